@@ -1,7 +1,96 @@
 #define INF -11451428
 #define MAX 11451428
-#define SEARCH_WIDTH 5 // 搜索宽度，控制每层只保留前5优先点
-#define SEARCH_DEPTH 6 // 搜索深度
+#define WIN_SCORE 1000000    // 终局获胜（或吃光对方）的分值
+#define ASPIRATION_WINDOW 60 // 渴望窗口半径，约为四步行动力差
+#define MAX_SEARCH_DEPTH 64 // 迭代加深的最大深度
+#define TIME_LIMIT_MS 100    // 裁判每步限时
+#define TIME_RESERVE_MS 30   // 留给进程间通信和线程调度的余量
+#define BB_WORDS 3     // 位棋盘的字数，12x12 共 144 格需要 3 个 64 位字
+#define MAX_CELLS (BB_WORDS * 64)
+#define MAX_SPREAD 5   // 沿一条线把空格扩散到整条线最多需要的移位次数（13 格的线要 1+2+4+4+4）
+#define MAX_PLY 160    // 撤销栈深度，不小于最大棋盘格数
+#define MAX_LINE 13    // 一条线最多的格子数，查表翻转的表按 2^13 种占位取下标
+#define TT_BITS 16     // 置换表共 2^16 个桶
+#define TT_WAYS 4      // 每个桶 4 项，正好一条 64 字节缓存行
+#define ORDER_TT (1 << 30)      // 走法排序：置换表中的最佳落子最先
+#define ORDER_KILLER (1 << 29)  // 其次是本层的杀手着法，其余按历史得分
+#define HISTORY_LIMIT (1 << 24) // 历史得分超过它就整体减半
+#define ETC_MIN_DEPTH 3         // 剩余深度不小于它的零窗口结点才做增强置换表剪枝
+#ifndef ENABLE_ETC
+#define ENABLE_ETC 0            // 增强置换表剪枝（ETC）开关：结点只少 1%~3%，多出的探查反而更慢，默认关闭
+#endif
+#define BOUND_EXACT 1  // 置换表中的值为准确值
+#define BOUND_LOWER 2  // 分值不低于 beta 时存下的下界
+#define BOUND_UPPER 3  // 分值不高于 alpha 时存下的上界
+#define MAX_THREADS 8  // 搜索线程数上限（含主线程）
+#ifndef ENDGAME_EMPTIES
+#define ENDGAME_EMPTIES 11      // 空格数不超过它时改用终局精确求解，12 空时偶尔超过限时
+#endif
+#ifndef ENABLE_PONDER
+#define ENABLE_PONDER 1         // 后台思考开关：对方思考时接着搜对方走棋的局面，填置换表
+#endif
+#ifndef ENABLE_MCTS
+#define ENABLE_MCTS 0           // 中局改用蒙特卡洛树搜索（MCTS）：同样限时下不如 alpha-beta，默认关闭
+#endif
+#define MCTS_NODES (1 << 20)    // MCTS 结点池大小，整局反复使用
+#define MCTS_EXPLORE 0.8        // UCT 的探索系数
+#define MCTS_DEPTH_PLAYOUTS 1000 // 固定深度测速时 MCTS 按每层 1000 次模拟算
+#define FASTEST_FIRST_EMPTIES 7 // 终局求解时空格数不少于它才按对方行动力排序，更少时只按奇偶
+#define EXACT_TT_EMPTIES 8      // 终局求解时空格数不少于它才查置换表
+#define UNKNOWN_VALUE 5         // 开局就有棋子的格子看不到分值，先按平均值算
+#ifndef BOOK_FILE
+#define BOOK_FILE "data/book.bin" // 开局库文件，相对 run.sh 所在目录；没有这个文件就不用开局库
+#endif
+#define BOOK_MAGIC 0x4B425652     // 开局库文件头的 "RVBK"
+#define BOOK_VERSION 2
+#define MAX_SYMMETRY 8            // 矩形棋盘的对称变换：翻转行、翻转列、转置的组合
+#define PATTERN_COUNT 5           // 估值模式的种数
+#define PATTERN_CELLS 10          // 一个模式最多的格子数，索引不超过 3^10，存得进 uint16_t
+#define PATTERN_INSTANCES 40      // 棋盘上放下的模式个数上限，12x12 共 36 个
+#define PATTERN_PER_SQ 12         // 一格最多属于的模式个数
+#define PATTERN_STAGES 4          // 按棋子数把一局分成几段，每段一套表
+#define PATTERN_SCALE 8           // 表中的分值以格子分值的 1/8 为单位
+#ifndef PATTERN_FILE
+#define PATTERN_FILE "data/pattern%d.bin" // 按棋盘边长的模式表，相对 run.sh 所在目录；没有时用手写的估值
+#endif
+#define PATTERN_MAGIC 0x54505652  // 模式表文件头的 "RVPT"
+#define PATTERN_VERSION 1
+#ifndef PROBCUT_FILE
+#define PROBCUT_FILE "data/probcut%d.bin" // 按棋盘边长的 Multi-ProbCut 回归参数，相对 run.sh 所在目录；没有时不做 ProbCut
+#endif
+#define PROBCUT_MAGIC 0x43505652  // ProbCut 参数文件头的 "RVPC"
+#define PROBCUT_VERSION 1
+#define PROBCUT_MIN_DEPTH 3       // 剩余深度不小于它的零窗口结点才做 ProbCut
+#define PROBCUT_MAX_DEPTH 16      // 参数表的深度上限，更深的结点用拟合到的最深一层的参数
+#define PROBCUT_STAGES 4          // 按棋子数把一局分成几段，每段一套参数
+#define PROBCUT_T 1.5             // 置信窗口：浅层搜索的预测值超出窗口边界 t 倍标准差才剪
+#ifndef TELEMETRY_FILE
+#define TELEMETRY_FILE "log/telemetry.bin" // 每步的搜索记录追加写到这里，相对 run.sh 所在目录；没有 log 目录就不写
+#endif
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_RING 256        // 记录环形缓冲的容量，大于一方一局最多的步数
+#define TELEMETRY_PV 16           // 每步记下的主要变例长度上限
+#define TELEMETRY_BOOK 1          // 记录的 flags：照开局库下
+#define TELEMETRY_EXACT 2         // 终局精确求解完成
+#define TELEMETRY_MCTS 4          // 用 MCTS 搜的
+#define TELEMETRY_PONDER_HIT 8    // 后台思考猜中了对方的落子
+#define TELEMETRY_TIMEOUT 16      // 到了限时，最后一轮迭代或终局求解被中止
+#define EVAL_BATCH 32             // 批量估值一组的局面数，是 4 的倍数；局面更多时分几组算
+#define WEIGHT_PLANES 10          // 格子权值减去最小值后的二进制位数，权值在 -45~500 之间
+#ifndef ENABLE_AVX2
+#if defined(__x86_64__) || defined(__i386__)
+#define ENABLE_AVX2 1             // 批量估值在支持 AVX2 的 CPU 上 4 个局面一起算，init 时检测 CPU，不支持时用标量版本
+#else
+#define ENABLE_AVX2 0
+#endif
+#endif
+#ifndef ENABLE_BMI2
+#if defined(__x86_64__)
+#define ENABLE_BMI2 1             // 查表翻转在支持 BMI2 的 CPU 上用 pext/pdep 取出和放回一条线上的格子，init 时检测 CPU，不支持时不查表
+#else
+#define ENABLE_BMI2 0
+#endif
+#endif
 
 #include <string.h>
 #include "../include/playerbase.h"
@@ -9,26 +98,399 @@
 #include <stdlib.h>
 #include <time.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <math.h>
+#if ENABLE_AVX2 || ENABLE_BMI2
+#include <immintrin.h>
+#endif
+
+// 位棋盘：第 x 行第 y 列对应第 x * col_cnt + y 位，8x8 只用到 w[0]
+struct BitBoard {
+    uint64_t w[BB_WORDS];
+};
+
+// 估值用到的逐项统计，按 discs 的下标分两方，落子时随翻转的棋子增量更新
+struct EvalTerms {
+    int weight[2]; // 格子权值之和
+    int count[2];  // 棋子数
+    int value[2];  // 格子分值之和（即裁判的得分）
+    uint16_t index[PATTERN_INSTANCES]; // 各个模式的三进制索引，每格一位：0 空、1 为 discs[0]、2 为 discs[1]
+};
+
+// 撤销记录：一步棋翻转的棋子和落子位置，sq 为 -1 表示停一手
+struct Undo {
+    struct BitBoard flips;
+    uint64_t hash;          // 落子前的局面哈希
+    struct EvalTerms terms; // 落子前的估值统计
+    int sq;
+};
+
+// 批量估值的一组局面：按字分开存（SoA），同一个字的各局面连续存放，AVX2 一次取 4 个局面
+// my 为各局面走棋的一方；算出的各项按局面在组里的下标写回
+struct EvalBatch {
+    int n;
+    uint64_t my[BB_WORDS][EVAL_BATCH];
+    uint64_t opp[BB_WORDS][EVAL_BATCH];
+    int moves[EVAL_BATCH];     // 己方可落子数
+    int opp_moves[EVAL_BATCH]; // 对方可落子数
+    int count[EVAL_BATCH];     // 子数之差
+    int weight[EVAL_BATCH];    // 格子权值之和的差
+};
+
+// 置换表项，多个线程不加锁同时读写
+// data 从低到高依次为 32 位分值、16 位最佳落子、8 位剩余深度、8 位 flags（低 2 位 BOUND_*，高 6 位代数）；
+// check 存 key ^ data，读到的两个字来自不同的写入时异或对不上，当作没有命中
+struct TTEntry {
+    uint64_t check;
+    uint64_t data;
+};
+
+// 解开后的置换表项
+struct TTInfo {
+    int value;
+    int move;  // 该局面下的最佳落子，没有为 -1
+    int depth; // 剩余搜索深度
+    int bound;
+    int generation;
+};
+
+struct TTBucket {
+    struct TTEntry entry[TT_WAYS];
+} __attribute__((aligned(64)));
+
+// 开局库文件：文件头之后是按 key 从小到大排好的表项
+// check 为建库时的 zobrist[0][0]，哈希的生成方式变了旧库就作废
+// pattern 记下建库时是否用的模式估值，表项的分值和当前估值不在一个尺度上时整个库不用
+struct BookHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t check;
+    uint64_t count;
+    uint32_t pattern;
+    uint32_t reserved;
+};
+
+// 开局库表项，key 为规范化后的局面哈希（见 bookKey），move 为规范化局面下的落子
+struct BookEntry {
+    uint64_t key;
+    int32_t move;
+    int32_t value; // 建库时搜索得到的分值，走棋一方视角
+};
+
+// 估值模式的形状：相对左上角的格子坐标，第 k 格为索引的第 k 位（3^k）
+struct PatternShape {
+    int len;
+    int cell[PATTERN_CELLS][2];
+};
+
+// 模式表文件：文件头之后依次为各段格子分值差的权重 int16_t[PATTERN_STAGES]，
+// 再是各段的表，每段按 pattern_shapes 的顺序各 3^len 项 int16_t；文件里的索引中 1 为走棋一方、2 为对方
+struct PatternHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;    // 棋盘边长
+    uint32_t stages;
+    uint64_t entries; // 每段的表项数
+};
+
+// Multi-ProbCut 参数文件：文件头之后为 ProbCut[stages][depths + 1]，第 d 项为剩余深度 d 的参数
+// pattern 记下拟合时是否用的模式估值，和当前估值不一致时参数不适用
+struct ProbCutHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;    // 棋盘边长
+    uint32_t stages;
+    uint32_t depths;  // 拟合到的最大深度
+    uint32_t pattern;
+};
+
+// 深度 d 的搜索值约为 a * 浅层搜索值 + b，残差的标准差为 sigma；sigma 为 0 表示这一层没有参数
+struct ProbCut {
+    float a, b, sigma;
+};
+
+// 每步的搜索记录，64 字节，按写入顺序追加到 TELEMETRY_FILE，由 src/stats_player.c 汇总
+// nodes、tt_*、cutoffs 为本步所有搜索线程之和；pv 为格子的位序号，第一项即本步的落子
+struct TelemetryRecord {
+    uint64_t game;          // 对局编号，init 时由时间和一个全局变量的地址（地址随机化后每个进程不同）生成
+    uint64_t nodes;
+    uint32_t tt_probes, tt_hits;
+    uint32_t cutoffs;       // beta 剪枝次数
+    uint32_t first_cutoffs; // 其中在第一个子结点就剪掉的次数
+    int32_t score;          // 根结点分值，走棋一方视角
+    float ms;               // place 的用时
+    uint8_t version;
+    uint8_t ply;            // 本局己方的第几步，从 1 开始
+    uint8_t rows, cols;
+    uint8_t empties;
+    uint8_t depth;          // 完成的深度
+    uint8_t flags;          // TELEMETRY_* 的组合
+    uint8_t pv_len;
+    uint8_t pv[TELEMETRY_PV];
+};
 
 // 八个方向向量，便于遍历棋盘方向
 int directions[8][2] = { 0, 1, 0, -1, 1, 0, -1, 0, 1, 1, -1, -1, 1, -1, -1, 1 };
 
+// 棋盘几何，init 时按地图大小计算
+int dir_shift[8];            // 每个方向在位序号上的偏移
+struct BitBoard dir_mask[8]; // 沿该方向移位后仍合法的格子（去掉越界和跨行绕回的位）
+struct BitBoard full_board;  // 棋盘内的所有格子
+struct BitBoard line_end[4]; // 横、竖、两条斜线四个方向上位于线两端的格子
+int spread_cnt;              // 空格扩散到整条线所需的移位次数
+int spread_len[MAX_SPREAD];  // 每次移位的步数：1, 2, 4, 4, ...，单次移位不超过 63 位
+struct BitBoard spread_mask[8][MAX_SPREAD]; // 沿该方向移 spread_len 步后仍合法的格子
+
+// 查表翻转：过一格的横、竖、两条斜线各取出己方和对方在线上的占位（第 k 位为线上第 k 格），
+// line_outflank[p][对方占位] 为从第 p 格往两边越过连续对方棋子后的第一格，和己方占位相与就是能夹住的端点，
+// line_flipped[p][端点] 为第 p 格和端点之间的格子；两张表和线长无关，越过线尾的端点和己方占位相与时自然去掉
+uint16_t line_outflank[MAX_LINE][1 << MAX_LINE];
+uint16_t line_flipped[MAX_LINE][1 << MAX_LINE];
+bool line_tables_ready;
+bool bmi2_enabled = ENABLE_BMI2; // 翻转用查表版本，init 时 CPU 不支持就改为 false；测速时可关掉和移位版本比较
+struct BitBoard line_mask[MAX_CELLS][4]; // 过第 sq 格的横、竖、主对角、副对角线上的格子，线上各格的位序号递增
+uint8_t line_offset[MAX_CELLS][4][BB_WORDS]; // 第 w 个字之前的字里有几格在线上，即该字取出的占位在线上从第几格起
+int sq_line_pos[MAX_CELLS][4];   // 第 sq 格在线上是第几格
+
 // 棋盘和权值表
 char board[13][13];         // 当前棋盘
 int weight[13][13];         // 每个格子的权值
-int best_x, best_y;         // 当前搜索到的最优落子点
+int sq_weight[MAX_CELLS];   // 按位序号排列的权值
+int weight_min;             // 最小的格子权值
+struct BitBoard weight_plane[WEIGHT_PLANES]; // 格子权值减去 weight_min 后二进制第 b 位为 1 的格子，批量估值按位算权值和
+bool avx2_enabled = ENABLE_AVX2; // 批量估值用 AVX2 版本，init 时 CPU 不支持就改为 false；测速时可关掉和标量版本比较
+int cell_value[MAX_CELLS];  // 每格的分值（地图上的数字），终局时占有格子的分值之和即为得分
+struct BitBoard unknown_value; // 分值未知的格子（开局就有棋子）
+struct BitBoard quadrant[4];   // 棋盘四个象限，终局按象限内空格数的奇偶排序
+int best_x, best_y;         // 最后一轮完整迭代得到的最优落子点
+long long search_nodes;     // 累计搜索结点数，用于测速
+long long search_evals;     // 累计静态估值次数，用于测速
+long long search_playouts;  // 累计 MCTS 模拟次数，用于测速
+
+// 一个搜索线程的全部状态，搜索时只改自己的这一份
+// 棋盘只有一份，落子和悔棋都在原地修改
+struct SearchContext {
+    struct Player *player;
+    struct BitBoard discs[2];           // 双方棋子，discs[side] 为当前走棋一方
+    int side;                           // 当前走棋一方
+    uint64_t hash_key;                  // 当前局面哈希，随 makeMove/unmakeMove 增量更新
+    struct EvalTerms terms;             // 当前局面的估值统计，随 makeMove/unmakeMove 增量更新
+    struct Undo undo_stack[MAX_PLY];    // 撤销栈
+    int undo_top;                       // 撤销栈栈顶
+    // 走法排序，整局游戏中保留，每次 place 时杀手着法清空、历史得分减半
+    int killer[MAX_PLY][2];             // 每层最近两次造成剪枝的落子
+    int history[2][MAX_CELLS];          // discs[c] 一方在第 sq 格落子造成剪枝的累计得分（深度平方）
+    int search_depth;                   // 本轮迭代的搜索深度
+    int root_x, root_y;                 // 本轮迭代中根结点当前的最优落子点
+    long long nodes;                    // 本次 place 搜索的结点数
+    long long tt_probes, tt_hits;       // 本次 place 的置换表查询和命中次数
+    long long evals;                    // 本次 place 的静态估值次数
+    long long playouts;                 // 本次 place 的 MCTS 模拟次数
+    long long cutoffs, first_cutoffs;   // 本次 place 的 beta 剪枝次数和其中第一个子结点就剪掉的次数
+    long long probcuts;                 // 本次 place 的 ProbCut 剪枝次数
+    bool in_probcut;                    // 正在做 ProbCut 的浅层搜索，里面不再嵌套
+    uint64_t rng;                       // MCTS 模拟用的随机数状态
+} __attribute__((aligned(64)));
+
+// 并行搜索（Lazy SMP）：主线程用 contexts[0] 做迭代加深并给出结果，
+// 帮手线程用同一个置换表各自迭代加深，奇数号帮手从深一层开始，把结果提前写进表里
+struct SearchContext contexts[MAX_THREADS];
+int search_threads;         // 搜索线程数，0 表示 init 时按 CPU 核数决定
+
+// 迭代加深和计时
+int last_depth;             // 最后一轮完整迭代的深度
+int fixed_depth;            // 非 0 时不计时，固定搜索到这个深度，供本地测速比较结点数
+double search_deadline;     // 超过这个时刻就中止搜索（毫秒）
+bool search_abort;          // 中止标志，置位后所有线程的 dfs 立即返回，本轮结果作废（原子读写）
+int endgame_empties = ENDGAME_EMPTIES; // 终局求解的空格数门槛
+int exact_empties;          // 本次 place 终局求解时的空格数，没有求解为 0
+bool exact_done;            // 本次 place 的终局求解是否在限时内完成
+double exact_ms;            // 本次 place 终局求解用时
+
+// 后台思考：place 返回前用单独的线程从对方走棋的局面接着搜（不限时），把结果留在置换表里；
+// 下一次 place 一开始就叫停，对方正好走了猜中的一步时 ponder_hit 为真
+bool ponder_enabled = ENABLE_PONDER; // 固定深度测速时不做，结点数才可比
+struct SearchContext ponder_ctx;    // 后台思考线程的搜索状态
+pthread_t ponder_thread;
+bool ponder_running;
+int ponder_move;            // 后台思考最后一轮完整迭代猜的对方落子，没有为 -1
+int ponder_depth;           // 后台思考完成的深度
+bool ponder_hit;            // 本次 place 的局面是否正好在猜中的那一步之后
+long long ponder_nodes;     // 累计后台思考的结点数
+
+// Zobrist 哈希和置换表，整局游戏中一直保留，init 时清空
+uint64_t zobrist[2][MAX_CELLS];     // 第 side 方在第 sq 格有棋子
+uint64_t zobrist_flip[MAX_CELLS];   // 翻转第 sq 格：zobrist[0][sq] ^ zobrist[1][sq]
+uint64_t zobrist_side;              // 轮到 discs[1] 一方走棋
+uint64_t zobrist_endgame;           // 终局权重生效，局面估值随之改变
+uint64_t zobrist_exact;             // 终局精确求解的表项，分值含义和启发式搜索不同，单独一套键
+struct TTBucket tt[1 << TT_BITS];   // 置换表，所有线程共用
+uint8_t tt_generation;              // 每次 place 加一，用于淘汰旧局面
+long long tt_probes, tt_hits;       // 累计查询次数和命中次数，用于统计命中率
+
+// 开局库，init 时映射进内存，整局只读
+// 局面按地图分值格局允许的对称变换规范化：各变换下的哈希取最小的一个
+const char *book_path = BOOK_FILE;   // 为 NULL 时不用开局库（建库时）
+const struct BookEntry *book;        // 映射进来的表项
+long long book_size;                 // 表项个数
+void *book_map;                      // mmap 得到的整个文件
+size_t book_map_size;
+int sym_cnt;                         // 当前地图可用的对称变换个数，第 0 个为恒等变换
+int sym_sq[MAX_SYMMETRY][MAX_CELLS]; // 第 t 个变换把第 sq 格变到哪一格
+int sym_inv[MAX_SYMMETRY][MAX_CELLS];// 逆变换
+uint64_t map_key;                    // 地图分值格局的哈希，不同地图的局面不会撞到一起
+bool book_hit;                       // 本次 place 是否直接用了开局库
+
+// 模式估值：角 3x3、边 + 2X、距边 1~3 行的横线，放在四个角的两个方向上，格子集合相同的只放一次；
+// 边长超过 8 的棋盘，边和横线只取从角出发的 8 格，两头各放一个。估值为各模式查表之和加上格子分值差
+// 乘一个系数，表由 src/train_player.c 离线拟合，init 时按棋盘边长读入，读不到就用手写的估值
+const struct PatternShape pattern_shapes[PATTERN_COUNT] = {
+    { 9, { { 0, 0 }, { 0, 1 }, { 0, 2 }, { 1, 0 }, { 1, 1 }, { 1, 2 }, { 2, 0 }, { 2, 1 }, { 2, 2 } } },
+    { 10, { { 0, 0 }, { 0, 1 }, { 0, 2 }, { 0, 3 }, { 0, 4 }, { 0, 5 }, { 0, 6 }, { 0, 7 }, { 1, 1 }, { 1, 6 } } },
+    { 8, { { 1, 0 }, { 1, 1 }, { 1, 2 }, { 1, 3 }, { 1, 4 }, { 1, 5 }, { 1, 6 }, { 1, 7 } } },
+    { 8, { { 2, 0 }, { 2, 1 }, { 2, 2 }, { 2, 3 }, { 2, 4 }, { 2, 5 }, { 2, 6 }, { 2, 7 } } },
+    { 8, { { 3, 0 }, { 3, 1 }, { 3, 2 }, { 3, 3 }, { 3, 4 }, { 3, 5 }, { 3, 6 }, { 3, 7 } } },
+};
+struct PatternRef {
+    int instance; // 第几个模式
+    int power;    // 这一格在索引中的位值 3^k
+};
+const char *pattern_path = PATTERN_FILE; // 为 NULL 时不读模式表（训练时用手写的估值生成对局）
+int pattern_size;                        // 每段的表项数
+int pattern_offset[PATTERN_COUNT];       // 每种模式的表在一段中的偏移
+int pattern_cnt;                         // 棋盘上放下的模式个数，棋盘不是 8 以上的方形时为 0
+int pattern_shape[PATTERN_INSTANCES];    // 第 i 个模式的种类
+int pattern_base[PATTERN_INSTANCES];     // 第 i 个模式的表在一段中的偏移
+int pattern_cell[PATTERN_INSTANCES][PATTERN_CELLS]; // 第 i 个模式的第 k 格
+int pattern_sq_cnt[MAX_CELLS];           // 落子和翻转时要更新的模式，没有读入模式表时为 0
+struct PatternRef pattern_sq[MAX_CELLS][PATTERN_PER_SQ];
+int pattern_stage[MAX_CELLS + 1];        // 棋子数所在的段
+int16_t pattern_value_weight[PATTERN_STAGES]; // 格子分值差的权重
+int16_t *pattern_table;                  // [2][PATTERN_STAGES][pattern_size]，第二份数字 1、2 互换，discs[1] 走棋时用
+
+// Multi-ProbCut：剩余深度 d 的零窗口结点先按 probcutShallow(d) 做浅层零窗口搜索，
+// 按回归式预测的深层值以 probcut_t 倍标准差的把握落在 [alpha, beta] 之外就直接返回；
+// 参数由 src/probcut_player.c 用自对弈中迭代加深各轮的根结点分值按段、按深度拟合，init 时按棋盘边长读入
+const char *probcut_path = PROBCUT_FILE; // 为 NULL 时不做 ProbCut（拟合参数时）
+double probcut_t = PROBCUT_T;
+int probcut_depths;                      // 读入的参数的最大深度，没有读入为 0
+struct ProbCut probcut[PROBCUT_STAGES][PROBCUT_MAX_DEPTH + 1];
+int probcut_stage[MAX_CELLS + 1];        // 棋子数所在的段
+long long search_probcuts;               // 累计 ProbCut 剪枝次数，用于测速
 
 // 参数
 int mobility_weight;        // 行动力权重
 int endgame_weight;         // 终局权重
-int piece_count;            // 棋子总数
+int last_score;             // 最后一轮完整迭代的根结点分值
+int depth_score[MAX_SEARCH_DEPTH + 1]; // 本次 place 每一轮完整迭代的根结点分值，拟合 ProbCut 参数用
+
+// 编译期棋盘几何：N 为方形棋盘的边长，移位量、位棋盘字数和扩散次数都是常量，
+// 按方向、按字的循环可以完全展开，8x8 只算 w[0]；掩码仍取 init 时算好的 dir_mask 等
+// N 为 0 时各项取 init 时算出的运行期几何，任意大小的棋盘都能用
+template <int N>
+struct Geometry {
+    static const int words = (N * N + 63) / 64;
+    // 方向 (dx, dy) 的偏移 dx * N + dy，方向顺序同 directions
+    static constexpr int shift(int dir) {
+        return dir == 0 ? 1 : dir == 1 ? -1 : dir == 2 ? N : dir == 3 ? -N
+             : dir == 4 ? N + 1 : dir == 5 ? -N - 1 : dir == 6 ? N - 1 : 1 - N;
+    }
+    // 空格扩散到整条线所需的移位次数和每次的步数，同 initGeometry
+    static constexpr int spreads(int reach = 0, int len = 1) {
+        return reach >= N - 1 ? 0 : 1 + spreads(reach + len, len < 4 ? len * 2 : 4);
+    }
+    static constexpr int spreadLen(int i) {
+        return i < 2 ? 1 << i : 4;
+    }
+};
+
+template <>
+struct Geometry<0> {
+    static const int words = BB_WORDS;
+    static int shift(int dir) { return dir_shift[dir]; }
+    static int spreads() { return spread_cnt; }
+    static int spreadLen(int i) { return spread_len[i]; }
+};
+
+// 按棋盘大小选定的搜索入口，init 时设置一次
+struct SearchEntry {
+    int (*searchIteration)(struct SearchContext *ctx, int last);
+    int (*solveExact)(struct SearchContext *ctx, int step, int alpha, int beta);
+    void *(*helperMain)(void *arg);
+    void *(*ponderMain)(void *arg);
+    void *(*mctsWorker)(void *arg);
+};
+struct SearchEntry search_entry;
+
+// 蒙特卡洛树搜索的结点，一个结点的子结点在池中连续存放
+// 多个线程不加锁同时读写：child_cnt 为 -1 表示未展开，展开的线程先写好子结点再写 child_cnt；
+// 下行时先给经过的结点加一次访问（虚拟损失），模拟结束再加上得分，其他线程暂时看到的胜率偏低，会选别的分支
+struct MctsNode {
+    int first_child; // 第一个子结点在池中的下标
+    int child_cnt;   // 子结点个数，-1 为未展开，0 为终局；无处可下时只有一个停一手的子结点
+    int move;        // 从父结点走到这里的落子，-1 为停一手
+    int visits;      // 访问次数，含正在进行的模拟
+    int wins;        // 父结点走棋一方的得分之和：胜 2、平 1、负 0
+    int expanding;   // 已有线程在展开
+};
+
+// MCTS：树在整局中保留，下一次 place 在旧树中找到当前局面就接着用，池快满了才清空
+bool mcts_enabled = ENABLE_MCTS;
+struct MctsNode mcts_pool[MCTS_NODES];
+int mcts_used;                  // 池中已分配的结点数（原子读写）
+int mcts_root;                  // 根结点在池中的下标，池为空时为 -1
+struct BitBoard mcts_root_discs[2]; // 根结点的局面，discs[0] 走棋
+long long mcts_budget;          // 固定深度测速时剩余的模拟次数（原子读写）
+struct BitBoard value_plane[4]; // 格子分值二进制第 b 位为 1 的格子，模拟结束时按位算得分
+
+// 搜索记录：place 结束时写进环形缓冲，只有一个写入方（走棋的线程）和一个读出方，不用加锁；
+// 读出方在后台思考线程开始时、下一局 init 时和进程退出时把缓冲追加写到文件，不占走棋的限时
+const char *telemetry_path = TELEMETRY_FILE; // 为 NULL 时不记录（训练、建库时）
+struct TelemetryRecord telemetry_ring[TELEMETRY_RING];
+unsigned telemetry_head;        // 已写入缓冲的记录数（原子读写）
+unsigned telemetry_tail;        // 已写到文件的记录数（原子读写）
+long long telemetry_dropped;    // 缓冲满时丢掉的记录数
+uint64_t telemetry_game;        // 当前对局编号
+int telemetry_ply;              // 当前对局己方已走的步数
+bool telemetry_registered;      // 是否已登记进程退出时写出
 
 // 函数声明
-// 计算己方稳定子数量（角、边、内部），用于评估局面稳定性
-int getStableDiscs(struct Player *player, char board[13][13]);
+// 以下带模板参数 N 的函数按 Geometry<N> 的几何实例化，不写模板参数时为运行期几何的通用版本
+// 位棋盘基本运算：按位与、或、去掉、是否为空、计数，只算前 W 个字
+template <int W = BB_WORDS> struct BitBoard bbAnd(struct BitBoard a, struct BitBoard b);
+template <int W = BB_WORDS> struct BitBoard bbOr(struct BitBoard a, struct BitBoard b);
+template <int W = BB_WORDS> struct BitBoard bbAndNot(struct BitBoard a, struct BitBoard b);
+template <int W = BB_WORDS> bool bbEmpty(struct BitBoard a);
+template <int W = BB_WORDS> int bbCount(struct BitBoard a);
+
+// 整体移位，k > 0 向高位，k < 0 向低位，|k| < 64
+template <int W = BB_WORDS> struct BitBoard bbShift(struct BitBoard a, int k);
+
+// 沿第dir个方向移动一格，并去掉移出棋盘的位
+template <int N = 0> struct BitBoard shiftDir(struct BitBoard a, int dir);
+
+// 取出并清除最低位，返回其位序号
+template <int W = BB_WORDS> int popLowest(struct BitBoard *a);
+
+// 计算四个方向上整条线都已落子的格子，full[k] 对应 line_end[k] 的方向
+template <int N = 0> void getFullLines(struct BitBoard occupied, struct BitBoard full[4]);
+
+// 计算己方稳定子数量，用于评估局面稳定性
+template <int N = 0> int getStableDiscs(struct BitBoard my, const struct BitBoard full[4]);
+
+// 己方所有合法落子点
+template <int N = 0> struct BitBoard getMoves(struct BitBoard my, struct BitBoard opp);
+
+// 在第sq格落子会翻转的对方棋子
+template <int N = 0> struct BitBoard getFlips(int sq, struct BitBoard my, struct BitBoard opp);
 
 // 判断(x, y)位置在当前棋盘上是否为合法落子点 ****
-int isValidMove(struct Player *player, int x, int y, char board[13][13]);
+int isValidMove(struct Player *player, int x, int y, struct BitBoard my, struct BitBoard opp);
 
 // 初始化棋盘和权值表，准备AI搜索
 void init(struct Player *player);
@@ -36,413 +498,2018 @@ void init(struct Player *player);
 // 选择当前局面下的最佳落子点（主入口）
 struct Point place(struct Player *player);
 
-// 统计棋盘上己方棋子数量
-int countDiscs(struct Player *player, char board[13][13]);
+// 统计棋盘上的棋子数量
+int countDiscs(struct BitBoard occupied);
+
+// 把 mat 转成双方的位棋盘，'O' 为己方
+void readBoard(struct Player *player, struct BitBoard *my, struct BitBoard *opp);
+
+// 按地图分值格局找出可用的对称变换并计算 map_key
+void initSymmetry(struct Player *player);
+
+// 规范化的局面哈希，sym 返回取到最小值的变换
+uint64_t bookKey(struct BitBoard my, struct BitBoard opp, int *sym);
+
+// 映射开局库文件，文件不存在或版本不符时不用开局库
+void loadBook();
+
+// 在开局库中查找局面，返回实际棋盘上的落子，没有返回 -1，value 返回库中的分值
+int bookProbe(struct BitBoard my, struct BitBoard opp, int *value);
+
+// 负极大值主要变例搜索（PVS），返回当前走棋一方视角的分值，可超出 [alpha, beta]（fail-soft）
+template <int N = 0> int dfs(struct SearchContext *ctx, int step, int alpha, int beta);
+
+// 以上一轮分值为中心开渴望窗口搜索一轮，返回根结点分值
+template <int N = 0> int searchIteration(struct SearchContext *ctx, int last);
+
+// 帮手线程入口
+template <int N = 0> void *helperMain(void *arg);
+
+// 己方在第sq格落子后开始后台思考
+void startPonder(struct Player *player, struct BitBoard my, struct BitBoard opp, int sq);
+
+// 叫停后台思考并汇总结点数
+void stopPonder();
+
+// 后台思考线程入口
+template <int N = 0> void *ponderMain(void *arg);
 
-// 极大极小搜索+剪枝，递归搜索最优解
-int dfs(struct Player *player, int step, char my_board[13][13], char opp_board[13][13], int alpha_beta);
+// 从 MCTS 结点池中分配 n 个连续结点
+int mctsAlloc(int n);
+
+// 展开 MCTS 结点，my 为该结点走棋一方
+template <int N = 0> bool mctsExpand(int node, struct BitBoard my, struct BitBoard opp);
+
+// 随机下到终局
+template <int N = 0> int mctsPlayout(struct SearchContext *ctx, struct BitBoard my, struct BitBoard opp);
+
+// MCTS 的一次选择、展开、模拟和回传
+template <int N = 0> void mctsIterate(struct SearchContext *ctx);
+
+// MCTS 线程入口
+template <int N = 0> void *mctsWorker(void *arg);
+
+// 复用上一步的树或清空结点池，设置根结点
+void mctsPrepare(struct BitBoard my, struct BitBoard opp);
+
+// MCTS 搜索当前局面，结果写进 best_x、best_y
+void mctsSearch(struct Player *player, struct BitBoard my, struct BitBoard opp);
+
+// 当前局面是否正好是后台思考猜中的对方落子之后的局面
+bool ponderHit(struct BitBoard my, struct BitBoard opp);
+
+// 把本次 place 的搜索统计写进记录缓冲
+void recordTelemetry(struct Player *player, double start, int flags, int sq);
+
+// 从第 sq 格开始，沿置换表里的最佳落子走出主要变例，返回长度
+int principalVariation(struct SearchContext *ctx, int sq, uint8_t *pv);
+
+// 把记录缓冲追加写到 telemetry_path
+void flushTelemetry();
+
+// 进程退出时停下后台思考，写出剩下的记录
+void exitTelemetry();
+
+// 本线程是否应当停止搜索；主线程的第一轮迭代不停，保证总有一步可下
+bool searchStopped(struct SearchContext *ctx);
+
+// 终局得分差：双方占有格子的分值之和相减，与裁判的计分方式相同
+int finalScore(struct SearchContext *ctx);
+
+// 终局精确求解，返回走棋一方视角的最终得分差
+template <int N = 0> int solveExact(struct SearchContext *ctx, int step, int alpha, int beta);
+
+// 根据裁判给出的双方得分推算开局棋子所在格的分值
+void learnValues(struct Player *player, struct BitBoard my, struct BitBoard opp);
 
 // 设置指定角落及其周围格子的权值
 void setCornerWeights(int x, int y);
 
-// 在(x, y)处落子，并翻转被夹住的对方棋子 ****
-void applyMove(struct Player *player, int x, int y, char my_board[13][13], char opp_board[13][13]);
+// 当前走棋一方在第sq格落子（-1 为停一手），翻转的棋子压入撤销栈，然后交换走棋方 ****
+template <int N = 0> void makeMove(struct SearchContext *ctx, int sq);
+
+// 撤销最近一次 makeMove
+template <int N = 0> void unmakeMove(struct SearchContext *ctx);
+
+// 计算一方棋子的格子权值之和
+int getBoardWeight(struct BitBoard my);
+
+// 静态估值，对走棋一方；读入了模式表时用模式估值
+template <int N = 0> int evaluate(struct SearchContext *ctx);
+
+// 模式估值，对走棋一方
+int evaluatePattern(struct SearchContext *ctx);
+
+// 按棋盘大小放下估值模式
+void initPatterns(struct Player *player);
 
-// 复制棋盘src到dest
-void copyBoard(int n, char dest[13][13], char src[13][13]);
+// 读入当前棋盘边长的模式表，读不到时不用模式估值
+void loadPatterns(struct Player *player);
 
-// 计算当前棋盘局面对己方的权值
-int getBoardWeight(struct Player *player, char board[13][13]);
+// 根据 discs 重新计算估值统计
+void initTerms(struct SearchContext *ctx);
+
+// 读入 ProbCut 参数，没有参数文件或和当前估值不匹配时 probcut_depths 为 0
+void loadProbCut(struct Player *player);
+
+// ProbCut 剩余深度 depth 的结点所用浅层搜索的深度，和 depth 奇偶相同
+int probcutShallow(int depth);
 
 // 计算己方与对方的行动力（可落子数）差值
-int getMobility(struct Player *player, char my_board[13][13], char opp_board[13][13]);
+template <int N = 0> int getMobility(struct BitBoard my, struct BitBoard opp);
+
+// 把局面放进批量估值的一组，返回它在组里的下标
+int batchAdd(struct EvalBatch *b, struct BitBoard my, struct BitBoard opp);
+
+// 一组局面的双方行动力、子数差和权值和之差，支持 AVX2 时 4 个局面一起算
+template <int N = 0> void evaluateBatch(struct EvalBatch *b);
+
+// 只算一组局面中己方的行动力
+template <int N = 0> void batchMobility(struct EvalBatch *b);
+
+// 根据棋盘大小计算移位量和掩码
+void initGeometry(struct Player *player);
 
-// 计算棋盘上己方棋子数量
-int countDiscs(struct Player* player, char board[13][13]) {
+// 生成查表翻转的两张表，只在第一次调用时生成
+void initLineTables();
+
+#if ENABLE_BMI2
+// 查表求在第 sq 格落子翻转的棋子：每条线用 pext 取占位、查两次表，再用 pdep 把翻转的格子放回位棋盘
+template <int W = BB_WORDS> __attribute__((target("bmi2"))) struct BitBoard lineFlips(int sq, struct BitBoard my, struct BitBoard opp);
+#endif
+
+// 选用 Geometry<N> 实例化的搜索入口
+template <int N> void selectEntry();
+
+// 生成 Zobrist 随机数并清空置换表
+void initHash();
+
+// 单调时钟，毫秒
+double clockMs();
+
+// 给第sq格落子打排序分，tt_move 为置换表中的最佳落子
+int moveScore(struct SearchContext *ctx, int step, int sq, int tt_move);
+
+// 剪枝后更新杀手着法和历史得分
+void updateOrdering(struct SearchContext *ctx, int step, int sq, int depth);
+
+// 新一步开始前整理走法排序信息
+void ageOrdering(struct SearchContext *ctx);
+
+// 根据 discs、side 和 endgame_weight 重新计算局面哈希
+uint64_t computeHash(struct SearchContext *ctx);
+
+// 在置换表中查找局面，找到时解开存进 info
+bool ttProbe(struct SearchContext *ctx, uint64_t key, struct TTInfo *info);
+
+// 写入置换表，桶满时替换旧代数中深度最浅的一项
+void ttStore(uint64_t key, int depth, int bound, int value, int move);
+
+template <int W>
+inline struct BitBoard bbAnd(struct BitBoard a, struct BitBoard b) {
+    for (int k = 0; k < W; k++)
+        a.w[k] &= b.w[k];
+    return a;
+}
+
+template <int W>
+inline struct BitBoard bbOr(struct BitBoard a, struct BitBoard b) {
+    for (int k = 0; k < W; k++)
+        a.w[k] |= b.w[k];
+    return a;
+}
+
+template <int W>
+inline struct BitBoard bbAndNot(struct BitBoard a, struct BitBoard b) {
+    for (int k = 0; k < W; k++)
+        a.w[k] &= ~b.w[k];
+    return a;
+}
+
+template <int W>
+inline bool bbEmpty(struct BitBoard a) {
+    uint64_t any = 0;
+    for (int k = 0; k < W; k++)
+        any |= a.w[k];
+    return any == 0;
+}
+
+template <int W>
+inline int bbCount(struct BitBoard a) {
     int count = 0;
-    for (int i = 0; i < player->row_cnt; i++) {
-        for (int j = 0; j < player->col_cnt; j++) {
-            if (board[i][j] == 'O' || board[i][j] == 'o') {
-                count++;
+    for (int k = 0; k < W; k++)
+        count += __builtin_popcountll(a.w[k]);
+    return count;
+}
+
+inline bool bbTest(struct BitBoard a, int sq) {
+    return (a.w[sq >> 6] >> (sq & 63)) & 1;
+}
+
+inline void bbSet(struct BitBoard *a, int sq) {
+    a->w[sq >> 6] |= 1ULL << (sq & 63);
+}
+
+// 用不到的高位字保持为 0，特化版本算出的位棋盘和通用版本的可以直接比较
+template <int W>
+inline struct BitBoard bbShift(struct BitBoard a, int k) {
+    struct BitBoard r = { { 0 } };
+    if (k > 0) {
+        for (int i = W - 1; i >= 0; i--)
+            r.w[i] = (a.w[i] << k) | (i > 0 ? a.w[i - 1] >> (64 - k) : 0);
+    } else {
+        k = -k;
+        for (int i = 0; i < W; i++)
+            r.w[i] = (a.w[i] >> k) | (i + 1 < W ? a.w[i + 1] << (64 - k) : 0);
+    }
+    return r;
+}
+
+template <int N>
+inline struct BitBoard shiftDir(struct BitBoard a, int dir) {
+    const int W = Geometry<N>::words;
+    return bbAnd<W>(bbShift<W>(a, Geometry<N>::shift(dir)), dir_mask[dir]);
+}
+
+template <int W>
+inline int popLowest(struct BitBoard *a) {
+    for (int k = 0; k < W; k++) {
+        if (a->w[k]) {
+            int sq = __builtin_ctzll(a->w[k]);
+            a->w[k] &= a->w[k] - 1;
+            return k * 64 + sq;
+        }
+    }
+    return -1;
+}
+
+// 计算棋盘上的棋子数量（双方合计）
+int countDiscs(struct BitBoard occupied) {
+    return bbCount(occupied);
+}
+
+// 空格沿第 K 条线的两个方向扩散
+template <int N, int K>
+inline struct BitBoard spreadLine(struct BitBoard empty) {
+    const int W = Geometry<N>::words;
+    for (int i = 0; i < Geometry<N>::spreads(); i++)
+    {
+        int len = Geometry<N>::spreadLen(i);
+        struct BitBoard fwd = bbAnd<W>(bbShift<W>(empty, Geometry<N>::shift(2 * K) * len), spread_mask[2 * K][i]);
+        struct BitBoard back = bbAnd<W>(bbShift<W>(empty, Geometry<N>::shift(2 * K + 1) * len), spread_mask[2 * K + 1][i]);
+        empty = bbOr<W>(empty, bbOr<W>(fwd, back));
+    }
+    return empty;
+}
+
+// 整线已满的格子
+// 空格沿一条线的两个方向按 1, 2, 4, 4... 步倍增扩散，扩散不到的格子所在的线上没有空格
+template <int N>
+void getFullLines(struct BitBoard occupied, struct BitBoard full[4]) {
+    const int W = Geometry<N>::words;
+    struct BitBoard empty = bbAndNot<W>(full_board, occupied);
+    full[0] = bbAndNot<W>(full_board, spreadLine<N, 0>(empty));
+    full[1] = bbAndNot<W>(full_board, spreadLine<N, 1>(empty));
+    full[2] = bbAndNot<W>(full_board, spreadLine<N, 2>(empty));
+    full[3] = bbAndNot<W>(full_board, spreadLine<N, 3>(empty));
+}
+
+// 第 K 条线上不会让棋子被翻转的格子：整线已满、线的一端、相邻的稳定子
+template <int N, int K>
+inline struct BitBoard anchoredLine(struct BitBoard stable, const struct BitBoard full[4]) {
+    const int W = Geometry<N>::words;
+    struct BitBoard anchored = bbOr<W>(full[K], line_end[K]);
+    return bbOr<W>(anchored, bbOr<W>(shiftDir<N>(stable, 2 * K), shiftDir<N>(stable, 2 * K + 1)));
+}
+
+// 计算稳定子数量
+// 一个己方棋子在四个方向上都满足下列之一就不会再被翻转：整条线已满、位于线的一端、
+// 线上相邻的某一侧是己方稳定子。从空集出发反复扩展到不再变化，角上的棋子第一轮就是稳定的，
+// 之后沿边和整线向内蔓延
+template <int N>
+int getStableDiscs(struct BitBoard my, const struct BitBoard full[4]) {
+    const int W = Geometry<N>::words;
+    struct BitBoard stable = { { 0 } };
+    for (;;)
+    {
+        struct BitBoard next = bbAnd<W>(bbAnd<W>(my, anchoredLine<N, 0>(stable, full)), anchoredLine<N, 1>(stable, full));
+        next = bbAnd<W>(bbAnd<W>(next, anchoredLine<N, 2>(stable, full)), anchoredLine<N, 3>(stable, full));
+        if (bbEmpty<W>(bbAndNot<W>(next, stable)))
+            break;
+        stable = next;
+    }
+    return bbCount<W>(stable);
+}
+
+// 沿第 DIR 个方向，从己方棋子出发连续穿过对方棋子后落在的空格
+// frontier 为本轮新穿过的对方棋子，连续的对方棋子一般不长，穿完即停
+template <int N, int DIR>
+inline struct BitBoard movesAlong(struct BitBoard my, struct BitBoard opp, struct BitBoard empty) {
+    const int W = Geometry<N>::words;
+    struct BitBoard frontier = bbAnd<W>(shiftDir<N>(my, DIR), opp);
+    struct BitBoard line = frontier;
+    while (!bbEmpty<W>(frontier))
+    {
+        frontier = bbAnd<W>(shiftDir<N>(frontier, DIR), opp);
+        line = bbOr<W>(line, frontier);
+    }
+    return bbAnd<W>(shiftDir<N>(line, DIR), empty);
+}
+
+// 所有合法落子点
+// 对每个方向，从己方棋子出发连续穿过对方棋子，落在空格上的位置即可落子
+template <int N>
+struct BitBoard getMoves(struct BitBoard my, struct BitBoard opp) {
+    const int W = Geometry<N>::words;
+    struct BitBoard empty = bbAndNot<W>(full_board, bbOr<W>(my, opp));
+    struct BitBoard moves = bbOr<W>(movesAlong<N, 0>(my, opp, empty), movesAlong<N, 1>(my, opp, empty));
+    moves = bbOr<W>(moves, bbOr<W>(movesAlong<N, 2>(my, opp, empty), movesAlong<N, 3>(my, opp, empty)));
+    moves = bbOr<W>(moves, bbOr<W>(movesAlong<N, 4>(my, opp, empty), movesAlong<N, 5>(my, opp, empty)));
+    return bbOr<W>(moves, bbOr<W>(movesAlong<N, 6>(my, opp, empty), movesAlong<N, 7>(my, opp, empty)));
+}
+
+// 沿第 DIR 个方向穿过连续的对方棋子，遇到己方棋子则中间的全部翻转
+template <int N, int DIR>
+inline struct BitBoard flipsAlong(struct BitBoard from, struct BitBoard my, struct BitBoard opp) {
+    const int W = Geometry<N>::words;
+    struct BitBoard line = { { 0 } };
+    struct BitBoard x = bbAnd<W>(shiftDir<N>(from, DIR), opp);
+    while (!bbEmpty<W>(x))
+    {
+        line = bbOr<W>(line, x);
+        x = shiftDir<N>(x, DIR);
+        if (!bbEmpty<W>(bbAnd<W>(x, my)))
+            return line;
+        x = bbAnd<W>(x, opp);
+    }
+    struct BitBoard none = { { 0 } };
+    return none;
+}
+
+// 在第sq格落子会翻转的棋子
+// 多个字的棋盘移位要在字间进位，查表快一倍以上；8x8 只有一个字，常量移位和查表一样快，就不查表
+template <int N>
+struct BitBoard getFlips(int sq, struct BitBoard my, struct BitBoard opp) {
+    const int W = Geometry<N>::words;
+#if ENABLE_BMI2
+    if (N != 8 && bmi2_enabled)
+        return lineFlips<W>(sq, my, opp);
+#endif
+    struct BitBoard from = { { 0 } };
+    bbSet(&from, sq);
+    struct BitBoard flips = bbOr<W>(flipsAlong<N, 0>(from, my, opp), flipsAlong<N, 1>(from, my, opp));
+    flips = bbOr<W>(flips, bbOr<W>(flipsAlong<N, 2>(from, my, opp), flipsAlong<N, 3>(from, my, opp)));
+    flips = bbOr<W>(flips, bbOr<W>(flipsAlong<N, 4>(from, my, opp), flipsAlong<N, 5>(from, my, opp)));
+    return bbOr<W>(flips, bbOr<W>(flipsAlong<N, 6>(from, my, opp), flipsAlong<N, 7>(from, my, opp)));
+}
+
+// 落子并翻转棋子
+// 只改动 discs 中被翻转的位，翻转的棋子记在撤销栈里，悔棋时原样翻回
+template <int N>
+void makeMove(struct SearchContext *ctx, int sq) {
+    const int W = Geometry<N>::words;
+    struct BitBoard *discs = ctx->discs;
+    int side = ctx->side;
+    struct Undo *undo = &ctx->undo_stack[ctx->undo_top++];
+    undo->sq = sq;
+    undo->hash = ctx->hash_key;
+    undo->terms = ctx->terms;
+    if (sq >= 0)
+    {
+        struct EvalTerms *terms = &ctx->terms;
+        undo->flips = getFlips<N>(sq, discs[side], discs[side ^ 1]);
+        discs[side ^ 1] = bbAndNot<W>(discs[side ^ 1], undo->flips);
+        discs[side] = bbOr<W>(discs[side], undo->flips);
+        bbSet(&discs[side], sq);
+        ctx->hash_key ^= zobrist[side][sq];
+        terms->weight[side] += sq_weight[sq];
+        terms->value[side] += cell_value[sq];
+        terms->count[side]++;
+        for (int k = 0; k < pattern_sq_cnt[sq]; k++)
+            terms->index[pattern_sq[sq][k].instance] += (side + 1) * pattern_sq[sq][k].power;
+        struct BitBoard flips = undo->flips;
+        while (!bbEmpty<W>(flips))
+        {
+            int f = popLowest<W>(&flips);
+            ctx->hash_key ^= zobrist_flip[f];
+            terms->weight[side] += sq_weight[f];
+            terms->weight[side ^ 1] -= sq_weight[f];
+            terms->value[side] += cell_value[f];
+            terms->value[side ^ 1] -= cell_value[f];
+            terms->count[side]++;
+            terms->count[side ^ 1]--;
+            // 这一位从 2 - side 变成 1 + side
+            for (int k = 0; k < pattern_sq_cnt[f]; k++)
+                terms->index[pattern_sq[f][k].instance] += side ? pattern_sq[f][k].power : -pattern_sq[f][k].power;
+        }
+    }
+    ctx->side ^= 1;
+    ctx->hash_key ^= zobrist_side;
+}
+
+// 悔棋
+template <int N>
+void unmakeMove(struct SearchContext *ctx) {
+    const int W = Geometry<N>::words;
+    struct BitBoard *discs = ctx->discs;
+    struct Undo *undo = &ctx->undo_stack[--ctx->undo_top];
+    int side = ctx->side ^= 1;
+    ctx->hash_key = undo->hash;
+    ctx->terms = undo->terms;
+    if (undo->sq >= 0)
+    {
+        struct BitBoard changed = undo->flips;
+        bbSet(&changed, undo->sq);
+        discs[side] = bbAndNot<W>(discs[side], changed);
+        discs[side ^ 1] = bbOr<W>(discs[side ^ 1], undo->flips);
+    }
+}
+
+// 计算行动力差值
+// 返回己方可落子数-对方可落子数
+template <int N>
+int getMobility(struct BitBoard my, struct BitBoard opp) {
+    const int W = Geometry<N>::words;
+    return bbCount<W>(getMoves<N>(my, opp)) - bbCount<W>(getMoves<N>(opp, my));
+}
+
+// 计算一方的格子权值之和
+int getBoardWeight(struct BitBoard my) {
+    int total_weight = 0;
+    while (!bbEmpty(my)) {
+        total_weight += sq_weight[popLowest(&my)];
+    }
+    return total_weight;
+}
+
+// 静态估值
+// 一方的得分为 权值和 + 10 * 稳定子 + 终局权重 * 子数，估值为双方得分之差再加行动力差，
+// 两边对称计算，交换双方后估值正好取反；一方被吃光直接返回极值
+// 权值和与子数取自增量维护的 terms，只有稳定子和行动力还要在位棋盘上现算，
+// 双方共用同一组整线掩码
+template <int N>
+int evaluate(struct SearchContext *ctx) {
+    const int W = Geometry<N>::words;
+    struct EvalTerms *terms = &ctx->terms;
+    int me = ctx->side, you = ctx->side ^ 1;
+    struct BitBoard my = ctx->discs[me], opp = ctx->discs[you];
+    ctx->evals++;
+    if (terms->count[me] == 0) return -WIN_SCORE;
+    if (terms->count[you] == 0) return WIN_SCORE;
+    if (pattern_table)
+        return evaluatePattern(ctx);
+    struct BitBoard full[4];
+    getFullLines<N>(bbOr<W>(my, opp), full);
+    int my_score = terms->weight[me] + 10 * getStableDiscs<N>(my, full) + endgame_weight * terms->count[me];
+    int opp_score = terms->weight[you] + 10 * getStableDiscs<N>(opp, full) + endgame_weight * terms->count[you];
+    return my_score - opp_score + mobility_weight * getMobility<N>(my, opp);
+}
+
+// 重新计算估值统计，每次 place 开始时调用一次
+void initTerms(struct SearchContext *ctx) {
+    for (int c = 0; c < 2; c++)
+    {
+        struct BitBoard b = ctx->discs[c];
+        ctx->terms.weight[c] = getBoardWeight(b);
+        ctx->terms.count[c] = bbCount(b);
+        ctx->terms.value[c] = 0;
+        while (!bbEmpty(b))
+            ctx->terms.value[c] += cell_value[popLowest(&b)];
+    }
+    for (int i = 0; i < pattern_cnt; i++)
+    {
+        int index = 0;
+        for (int k = pattern_shapes[pattern_shape[i]].len - 1; k >= 0; k--)
+        {
+            int sq = pattern_cell[i][k];
+            index = index * 3 + (bbTest(ctx->discs[0], sq) ? 1 : bbTest(ctx->discs[1], sq) ? 2 : 0);
+        }
+        ctx->terms.index[i] = index;
+    }
+}
+
+// 模式估值
+// 一段的表都按走棋一方为 1 存，discs[1] 走棋时用数字互换过的那一份；走棋一方的估值，
+// 不要求交换双方后正好取反，先手的优势也算在表里
+int evaluatePattern(struct SearchContext *ctx) {
+    struct EvalTerms *terms = &ctx->terms;
+    int me = ctx->side, you = ctx->side ^ 1;
+    int stage = pattern_stage[terms->count[0] + terms->count[1]];
+    const int16_t *table = pattern_table + (me * PATTERN_STAGES + stage) * pattern_size;
+    int score = pattern_value_weight[stage] * (terms->value[me] - terms->value[you]);
+    for (int i = 0; i < pattern_cnt; i++)
+        score += table[pattern_base[i] + terms->index[i]];
+    return score;
+}
+
+// 批量估值
+// 一组局面的各项分别算，和 evaluate 的行动力、子数、权值和一一对应（不含稳定子）；
+// 走法排序时落子后的子局面不必真的落子，复制位棋盘放进一组一起算
+int batchAdd(struct EvalBatch *b, struct BitBoard my, struct BitBoard opp) {
+    int i = b->n++;
+    for (int k = 0; k < BB_WORDS; k++)
+    {
+        b->my[k][i] = my.w[k];
+        b->opp[k][i] = opp.w[k];
+    }
+    return i;
+}
+
+// 标量版本：逐个局面取出位棋盘照常计算
+template <int N>
+void batchTermsScalar(struct EvalBatch *b, bool all) {
+    const int W = Geometry<N>::words;
+    for (int i = 0; i < b->n; i++)
+    {
+        struct BitBoard my = { { 0 } }, opp = { { 0 } };
+        for (int k = 0; k < W; k++)
+        {
+            my.w[k] = b->my[k][i];
+            opp.w[k] = b->opp[k][i];
+        }
+        b->moves[i] = bbCount<W>(getMoves<N>(my, opp));
+        if (!all)
+            continue;
+        b->opp_moves[i] = bbCount<W>(getMoves<N>(opp, my));
+        b->count[i] = bbCount<W>(my) - bbCount<W>(opp);
+        b->weight[i] = getBoardWeight(my) - getBoardWeight(opp);
+    }
+}
+
+#if ENABLE_AVX2
+// AVX2 版本：4 个局面一起算，位棋盘的每个字占一个 256 位寄存器，每个局面占其中 64 位
+// 编译选项不开 AVX2，这几个函数单独按 AVX2 编译，只在 init 检测到 CPU 支持时调用
+// 整体移位，同 bbShift
+template <int W>
+__attribute__((target("avx2"))) inline void vecShift(const __m256i *a, __m256i *r, int k) {
+    if (k > 0)
+    {
+        __m128i left = _mm_cvtsi32_si128(k), right = _mm_cvtsi32_si128(64 - k);
+        for (int i = W - 1; i >= 0; i--)
+            r[i] = i > 0 ? _mm256_or_si256(_mm256_sll_epi64(a[i], left), _mm256_srl_epi64(a[i - 1], right)) : _mm256_sll_epi64(a[i], left);
+    }
+    else
+    {
+        __m128i right = _mm_cvtsi32_si128(-k), left = _mm_cvtsi32_si128(64 + k);
+        for (int i = 0; i < W; i++)
+            r[i] = i + 1 < W ? _mm256_or_si256(_mm256_srl_epi64(a[i], right), _mm256_sll_epi64(a[i + 1], left)) : _mm256_srl_epi64(a[i], right);
+    }
+}
+
+// 合法落子点，同 getMoves：每个方向从己方棋子出发穿过对方棋子，4 个局面都走到头才停
+template <int N>
+__attribute__((target("avx2"))) inline void vecMoves(const __m256i *my, const __m256i *opp, __m256i *moves) {
+    const int W = Geometry<N>::words;
+    __m256i empty[W];
+    for (int k = 0; k < W; k++)
+    {
+        empty[k] = _mm256_andnot_si256(_mm256_or_si256(my[k], opp[k]), _mm256_set1_epi64x(full_board.w[k]));
+        moves[k] = _mm256_setzero_si256();
+    }
+    for (int dir = 0; dir < 8; dir++)
+    {
+        int shift = Geometry<N>::shift(dir);
+        __m256i mask[W], pass[W], frontier[W], line[W], t[W];
+        __m256i any = _mm256_setzero_si256();
+        vecShift<W>(my, t, shift);
+        for (int k = 0; k < W; k++)
+        {
+            mask[k] = _mm256_set1_epi64x(dir_mask[dir].w[k]);
+            pass[k] = _mm256_and_si256(mask[k], opp[k]);
+            line[k] = frontier[k] = _mm256_and_si256(t[k], pass[k]);
+            any = _mm256_or_si256(any, frontier[k]);
+        }
+        while (!_mm256_testz_si256(any, any))
+        {
+            vecShift<W>(frontier, t, shift);
+            any = _mm256_setzero_si256();
+            for (int k = 0; k < W; k++)
+            {
+                frontier[k] = _mm256_and_si256(t[k], pass[k]);
+                line[k] = _mm256_or_si256(line[k], frontier[k]);
+                any = _mm256_or_si256(any, frontier[k]);
             }
         }
+        vecShift<W>(line, t, shift);
+        for (int k = 0; k < W; k++)
+            moves[k] = _mm256_or_si256(moves[k], _mm256_and_si256(_mm256_and_si256(t[k], mask[k]), empty[k]));
     }
-    return count;
 }
 
-// 计算稳定子数量（角、边等）
-// 返回己方棋盘上不会再被翻转的棋子数量
-int getStableDiscs(struct Player* player, char board[13][13]) {
-    int stable[3] = { 0, 0, 0 }; // stable[0]:角落, stable[1]:边, stable[2]:内部
-    int cind1[4] = { 0 };
-    int cind2[4] = { 0 }; // 四个角的行列索引
-    cind1[2] = cind1[3] = player->col_cnt - 1;
-    cind2[1] = cind2[2] = player->col_cnt - 1;
-    int inc1[4] = { 0, 1, 0, -1 }; // 行方向增量
-    int inc2[4] = { 1, 0, -1, 0 }; // 列方向增量
-    int stop[4] = { 0 };
-    int i, j;
-    // 检查四个角及其延伸方向上的稳定子
-    for (i = 0; i < 4; i++)
-    {
-        // 如果角落有己方棋子
-        if (board[cind1[i]][cind2[i]] == 'O')
-        {
-            stop[i] = 1;
-            stable[0] += 1; // 角落稳定子+1
-            // 沿着边界方向继续查找稳定子
-            for (j = 1; j < player->col_cnt; j++)
+// 各局面的棋子数：每 4 位查一次表，再按字节求和
+template <int W>
+__attribute__((target("avx2"))) inline __m256i vecCount(const __m256i *a) {
+    const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0f);
+    __m256i bytes = _mm256_setzero_si256();
+    for (int k = 0; k < W; k++)
+    {
+        __m256i lo = _mm256_and_si256(a[k], low), hi = _mm256_and_si256(_mm256_srli_epi16(a[k], 4), low);
+        bytes = _mm256_add_epi8(bytes, _mm256_add_epi8(_mm256_shuffle_epi8(table, lo), _mm256_shuffle_epi8(table, hi)));
+    }
+    return _mm256_sad_epu8(bytes, _mm256_setzero_si256());
+}
+
+// 两组位棋盘棋子数之差
+template <int W>
+__attribute__((target("avx2"))) inline __m256i vecCountDiff(const __m256i *a, const __m256i *b) {
+    return _mm256_sub_epi64(vecCount<W>(a), vecCount<W>(b));
+}
+
+// 每个局面的 64 位结果取低 32 位写回
+__attribute__((target("avx2"))) inline void vecStore(int *out, __m256i v) {
+    __m256i packed = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6));
+    _mm_storeu_si128((__m128i *)out, _mm256_castsi256_si128(packed));
+}
+
+template <int N>
+__attribute__((target("avx2"))) void batchTermsAvx2(struct EvalBatch *b, bool all) {
+    const int W = Geometry<N>::words;
+    // 凑不满 4 个的空位放空棋盘
+    for (int i = b->n; i & 3; i++)
+        for (int k = 0; k < BB_WORDS; k++)
+            b->my[k][i] = b->opp[k][i] = 0;
+    for (int i = 0; i < b->n; i += 4)
+    {
+        __m256i my[W], opp[W], moves[W];
+        for (int k = 0; k < W; k++)
+        {
+            my[k] = _mm256_loadu_si256((const __m256i *)&b->my[k][i]);
+            opp[k] = _mm256_loadu_si256((const __m256i *)&b->opp[k][i]);
+        }
+        vecMoves<N>(my, opp, moves);
+        vecStore(b->moves + i, vecCount<W>(moves));
+        if (!all)
+            continue;
+        vecMoves<N>(opp, my, moves);
+        vecStore(b->opp_moves + i, vecCount<W>(moves));
+        __m256i count = vecCountDiff<W>(my, opp);
+        vecStore(b->count + i, count);
+        // 权值和 = weight_min * 子数 + 按位平面逐位计数；只取低 32 位，差值为负也不影响
+        __m256i weight = _mm256_mullo_epi32(count, _mm256_set1_epi32(weight_min));
+        for (int bit = 0; bit < WEIGHT_PLANES; bit++)
+        {
+            __m256i my_bits[W], opp_bits[W];
+            for (int k = 0; k < W; k++)
             {
-                if (board[cind1[i] + inc1[i] * j][cind2[i] + inc2[i] * j] != 'O')
-                {
-                    break;
-                }
-                else
-                {
-                    stop[i] = j + 1;
-                    stable[1] += 1; // 边稳定子+1
-                }
+                __m256i plane = _mm256_set1_epi64x(weight_plane[bit].w[k]);
+                my_bits[k] = _mm256_and_si256(my[k], plane);
+                opp_bits[k] = _mm256_and_si256(opp[k], plane);
             }
+            weight = _mm256_add_epi64(weight, _mm256_sll_epi64(vecCountDiff<W>(my_bits, opp_bits), _mm_cvtsi32_si128(bit)));
         }
+        vecStore(b->weight + i, weight);
+    }
+}
+#endif
+
+template <int N>
+void evaluateBatch(struct EvalBatch *b) {
+#if ENABLE_AVX2
+    if (avx2_enabled)
+    {
+        batchTermsAvx2<N>(b, true);
+        return;
+    }
+#endif
+    batchTermsScalar<N>(b, true);
+}
+
+template <int N>
+void batchMobility(struct EvalBatch *b) {
+#if ENABLE_AVX2
+    if (avx2_enabled)
+    {
+        batchTermsAvx2<N>(b, false);
+        return;
+    }
+#endif
+    batchTermsScalar<N>(b, false);
+}
+
+inline bool searchStopped(struct SearchContext *ctx) {
+    return __atomic_load_n(&search_abort, __ATOMIC_RELAXED) && (ctx != &contexts[0] || ctx->search_depth > 1);
+}
+
+// 搜索主函数，负极大值 + 主要变例搜索
+// 第一个子结点用完整窗口，其余先用零窗口 (alpha, alpha + 1) 试探，试探结果落在窗口内再完整重搜
+template <int N>
+int dfs(struct SearchContext *ctx, int step, int alpha, int beta) {
+    const int W = Geometry<N>::words;
+    struct Player *player = ctx->player;
+    ctx->nodes++;
+    // 每 256 个结点看一次表
+    if ((ctx->nodes & 255) == 0 && clockMs() > search_deadline)
+    {
+        __atomic_store_n(&search_abort, true, __ATOMIC_RELAXED);
+    }
+    if (searchStopped(ctx))
+    {
+        return 0;
     }
-    // 检查边界反方向上的稳定子
-    for (i = 0; i < 4; i++)
+    struct BitBoard my = ctx->discs[ctx->side], opp = ctx->discs[ctx->side ^ 1];
+    int depth = ctx->search_depth + 1 - step;
+    // 查置换表，根结点需要给出落子点，不直接返回，只用表中的最佳落子排序；叶结点估值比访问置换表更便宜，不进表
+    struct TTInfo entry;
+    bool found = depth > 0 && ttProbe(ctx, ctx->hash_key, &entry);
+    int tt_move = found ? entry.move : -1;
+    if (found && step > 1 && entry.depth >= depth)
     {
-        if (board[cind1[i]][cind2[i]] == 'O')
+        if (entry.bound == BOUND_EXACT
+            || (entry.bound == BOUND_LOWER && entry.value >= beta)
+            || (entry.bound == BOUND_UPPER && entry.value <= alpha))
         {
-            for (j = 1; j < player->col_cnt - stop[(i + 3) % 4]; j++)
+            return entry.value;
+        }
+    }
+    // 搜索到最大深度，直接评估局面
+    if (depth <= 0)
+    {
+        return evaluate<N>(ctx);
+    }
+    // Multi-ProbCut：浅层搜索的预测值大概率不低于 beta 或不高于 alpha 就剪掉
+    if (probcut_depths > 0 && beta - alpha == 1 && step > 1 && depth >= PROBCUT_MIN_DEPTH && !ctx->in_probcut
+        && beta < WIN_SCORE / 2 && alpha > -WIN_SCORE / 2)
+    {
+        const struct ProbCut *pc = &probcut[probcut_stage[ctx->terms.count[0] + ctx->terms.count[1]]][depth < probcut_depths ? depth : probcut_depths];
+        if (pc->sigma > 0)
+        {
+            int shallow = probcutShallow(depth);
+            int result = INF;
+            ctx->in_probcut = true;
+            ctx->search_depth -= depth - shallow;
+            int bound = (int)ceil((beta + probcut_t * pc->sigma - pc->b) / pc->a);
+            if (dfs<N>(ctx, step, bound - 1, bound) >= bound)
+                result = beta;
+            if (result == INF)
             {
-                if (board[cind1[i] - inc1[(i + 3) % 4] * j][cind2[i] - inc2[(i + 3) % 4] * j] != 'O')
-                {
-                    break;
-                }
-                else
+                bound = (int)floor((alpha - probcut_t * pc->sigma - pc->b) / pc->a);
+                if (dfs<N>(ctx, step, bound, bound + 1) <= bound)
+                    result = alpha;
+            }
+            ctx->search_depth += depth - shallow;
+            ctx->in_probcut = false;
+            if (searchStopped(ctx))
+            {
+                return 0;
+            }
+            if (result != INF)
+            {
+                ctx->probcuts++;
+                return result;
+            }
+        }
+    }
+    struct BitBoard moves = getMoves<N>(my, opp);
+    // 无法落子：对方也无法落子则终局，否则停一手
+    if (bbEmpty<W>(moves))
+    {
+        if (step == 1)
+        {
+            ctx->root_x = -1, ctx->root_y = -1;
+            return 0;
+        }
+        if (bbEmpty<W>(getMoves<N>(opp, my)))
+        {
+            int diff = finalScore(ctx);
+            return diff > 0 ? WIN_SCORE + diff : diff < 0 ? -WIN_SCORE + diff : 0;
+        }
+        makeMove<N>(ctx, -1);
+        int value = -dfs<N>(ctx, step + 1, -beta, -alpha);
+        unmakeMove<N>(ctx);
+        return value;
+    }
+    // 给所有合法落子打排序分，搜索时每次挑剩下分最高的一个
+    int sq[MAX_CELLS], score[MAX_CELLS];
+    int n = 0;
+    while (!bbEmpty<W>(moves))
+    {
+        sq[n] = popLowest<W>(&moves);
+        score[n] = moveScore(ctx, step, sq[n], tt_move);
+        n++;
+    }
+#if ENABLE_ETC
+    // 增强置换表剪枝：零窗口结点先看一遍所有子局面，有子局面在表中已足以剪枝就直接返回
+    if (beta - alpha == 1 && depth >= ETC_MIN_DEPTH)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            makeMove<N>(ctx, sq[i]);
+            struct TTInfo child;
+            bool hit = ttProbe(ctx, ctx->hash_key, &child);
+            unmakeMove<N>(ctx);
+            if (hit && child.depth >= depth - 1 && child.bound != BOUND_LOWER && -child.value >= beta)
+            {
+                return -child.value;
+            }
+        }
+    }
+#endif
+    int alpha_orig = alpha;
+    int best_value = INF;
+    int best_sq = -1;
+    for (int i = 0; i < n; i++)
+    {
+        int pick = i;
+        for (int j = i + 1; j < n; j++)
+        {
+            if (score[j] > score[pick])
+                pick = j;
+        }
+        int t = sq[i]; sq[i] = sq[pick]; sq[pick] = t;
+        t = score[i]; score[i] = score[pick]; score[pick] = t;
+        makeMove<N>(ctx, sq[i]);
+        int value;
+        if (i == 0)
+        {
+            value = -dfs<N>(ctx, step + 1, -beta, -alpha);
+        }
+        else
+        {
+            value = -dfs<N>(ctx, step + 1, -alpha - 1, -alpha);
+            if (value > alpha && value < beta)
+            {
+                value = -dfs<N>(ctx, step + 1, -beta, -alpha);
+            }
+        }
+        unmakeMove<N>(ctx);
+        if (searchStopped(ctx))
+        {
+            return 0;
+        }
+        if (value > best_value)
+        {
+            best_value = value;
+            best_sq = sq[i];
+            if (step == 1)
+            {
+                ctx->root_x = sq[i] / player->col_cnt;
+                ctx->root_y = sq[i] % player->col_cnt;
+            }
+            if (value > alpha)
+            {
+                alpha = value;
+                if (alpha >= beta)
                 {
-                    stable[1] += 1;
+                    ctx->cutoffs++;
+                    ctx->first_cutoffs += i == 0;
+                    updateOrdering(ctx, step, sq[i], depth);
+                    break; // 剪枝
                 }
             }
         }
     }
-    // 检查整行、整列、对角线是否全为己方棋子
-    int colfull[13] = { 0 };
-    int rowfull[13] = { 0 };
-    int diag1full[26] = { 0 };
-    int diag2full[26] = { 0 };
-    for (i = 0; i < player->col_cnt; i++)
+    // fail-soft：存下实际搜到的最好分值和它相对窗口的位置
+    int bound = best_value <= alpha_orig ? BOUND_UPPER : best_value >= beta ? BOUND_LOWER : BOUND_EXACT;
+    ttStore(ctx->hash_key, depth, bound, best_value, best_sq);
+    return best_value;
+}
+
+// 搜索一轮
+// 从第三轮起在上一轮分值附近开渴望窗口，落在窗口外就把那一侧放宽一倍重搜
+template <int N>
+int searchIteration(struct SearchContext *ctx, int last) {
+    int delta = ASPIRATION_WINDOW;
+    int alpha = ctx->search_depth >= 3 ? last - delta : INF;
+    int beta = ctx->search_depth >= 3 ? last + delta : MAX;
+    while (true)
     {
-        // 检查第i行是否全为己方棋子
-        for (j = 0; j < player->col_cnt; j++)
+        int value = dfs<N>(ctx, 1, alpha, beta);
+        if (searchStopped(ctx))
         {
-            if (board[i][j] != 'O' && board[i][j] != 'o')
-                break;
+            return value;
         }
-        if (j == player->col_cnt)
-            rowfull[i] = 1;
-        // 检查第i列是否全为己方棋子
-        for (j = 0; j < player->col_cnt; j++)
+        if (value <= alpha && alpha > INF)
         {
-            if (board[j][i] != 'O' && board[j][i] != 'o')
-                break;
+            alpha = value - delta > INF ? value - delta : INF;
+        }
+        else if (value >= beta && beta < MAX)
+        {
+            beta = value + delta < MAX ? value + delta : MAX;
+        }
+        else
+        {
+            return value;
+        }
+        delta *= 2;
+    }
+}
+
+// 帮手线程：和主线程搜同一个局面，只为填置换表，结果不用
+// 编号为奇数的从第二层开始，和主线程错开一层，主线程结束或超时时停下
+template <int N>
+void *helperMain(void *arg) {
+    struct SearchContext *ctx = (struct SearchContext *)arg;
+    int last = 0;
+    for (ctx->search_depth = 1 + (ctx - contexts) % 2; ctx->search_depth <= MAX_SEARCH_DEPTH; ctx->search_depth++)
+    {
+        last = searchIteration<N>(ctx, last);
+        if (searchStopped(ctx))
+        {
+            break;
+        }
+    }
+    return NULL;
+}
+
+// 后台思考
+// 根结点为己方落子后的局面，对方无处可下时再替对方停一手；终局权重按对方落子之后的棋子数定，
+// 和下一次 place 的局面哈希一致。空格少到下一步会精确求解时直接精确求解，否则不限时迭代加深
+void startPonder(struct Player *player, struct BitBoard my, struct BitBoard opp, int sq) {
+    struct SearchContext *ctx = &ponder_ctx;
+    ctx->player = player;
+    ctx->discs[0] = my;
+    ctx->discs[1] = opp;
+    ctx->side = 0;
+    ctx->undo_top = 0;
+    initTerms(ctx);
+    makeMove(ctx, sq);
+    struct BitBoard occupied = bbOr(ctx->discs[0], ctx->discs[1]);
+    int chess = countDiscs(occupied);
+    if (bbEmpty(getMoves(ctx->discs[1], ctx->discs[0])))
+    {
+        if (bbEmpty(getMoves(ctx->discs[0], ctx->discs[1])))
+            return;
+        makeMove(ctx, -1);
+    }
+    else
+    {
+        chess++;
+    }
+    endgame_weight = player->row_cnt * player->row_cnt - chess <= player->row_cnt ? 2 : 0;
+    ctx->hash_key = computeHash(ctx);
+    ctx->nodes = ctx->tt_probes = ctx->tt_hits = ctx->evals = 0;
+    ageOrdering(ctx);
+    ponder_move = -1;
+    ponder_depth = 0;
+    search_deadline = 1e300;
+    __atomic_store_n(&search_abort, false, __ATOMIC_RELAXED);
+    ponder_running = pthread_create(&ponder_thread, NULL, search_entry.ponderMain, ctx) == 0;
+}
+
+template <int N>
+void *ponderMain(void *arg) {
+    const int W = Geometry<N>::words;
+    struct SearchContext *ctx = (struct SearchContext *)arg;
+    flushTelemetry();
+    struct Player *player = ctx->player;
+    int empties = player->row_cnt * player->col_cnt - countDiscs(bbOr<W>(ctx->discs[0], ctx->discs[1]));
+    if (empties - (ctx->side == 1) <= endgame_empties)
+    {
+        ctx->search_depth = empties;
+        solveExact<N>(ctx, 1, INF, MAX);
+        return NULL;
+    }
+    int last = ctx->side == 1 ? -last_score : last_score;
+    for (ctx->search_depth = 1; ctx->search_depth <= empties && ctx->search_depth <= MAX_SEARCH_DEPTH; ctx->search_depth++)
+    {
+        last = searchIteration<N>(ctx, last);
+        if (searchStopped(ctx) || ctx->root_x == -1)
+            break;
+        ponder_depth = ctx->search_depth;
+        ponder_move = ctx->root_x * player->col_cnt + ctx->root_y;
+    }
+    return NULL;
+}
+
+void stopPonder() {
+    if (!ponder_running)
+        return;
+    __atomic_store_n(&search_abort, true, __ATOMIC_RELAXED);
+    pthread_join(ponder_thread, NULL);
+    ponder_running = false;
+    ponder_nodes += ponder_ctx.nodes;
+}
+
+// 在后台思考的根结点上走猜的那一步，再和实际局面比较
+bool ponderHit(struct BitBoard my, struct BitBoard opp) {
+    if (ponder_move < 0 || ponder_ctx.side != 1)
+        return false;
+    makeMove(&ponder_ctx, ponder_move);
+    ponder_move = -1;
+    return memcmp(&ponder_ctx.discs[0], &my, sizeof(my)) == 0 && memcmp(&ponder_ctx.discs[1], &opp, sizeof(opp)) == 0;
+}
+
+void recordTelemetry(struct Player *player, double start, int flags, int sq) {
+    if (!telemetry_path)
+        return;
+    struct TelemetryRecord rec;
+    memset(&rec, 0, sizeof(rec));
+    long long nodes = 0, probes = 0, hits = 0, cutoffs = 0, first_cutoffs = 0;
+    for (int t = 0; t < search_threads; t++)
+    {
+        nodes += contexts[t].nodes;
+        probes += contexts[t].tt_probes;
+        hits += contexts[t].tt_hits;
+        cutoffs += contexts[t].cutoffs;
+        first_cutoffs += contexts[t].first_cutoffs;
+    }
+    rec.game = telemetry_game;
+    rec.nodes = nodes;
+    rec.tt_probes = (uint32_t)probes;
+    rec.tt_hits = (uint32_t)hits;
+    rec.cutoffs = (uint32_t)cutoffs;
+    rec.first_cutoffs = (uint32_t)first_cutoffs;
+    rec.score = last_score;
+    rec.version = TELEMETRY_VERSION;
+    rec.ply = (uint8_t)++telemetry_ply;
+    rec.rows = player->row_cnt;
+    rec.cols = player->col_cnt;
+    rec.empties = player->row_cnt * player->col_cnt - countDiscs(bbOr(contexts[0].discs[0], contexts[0].discs[1]));
+    rec.depth = last_depth;
+    rec.flags = flags | (ponder_hit ? TELEMETRY_PONDER_HIT : 0);
+    if (sq >= 0)
+    {
+        // MCTS 不写置换表，主要变例只有本步的落子
+        rec.pv_len = flags & (TELEMETRY_BOOK | TELEMETRY_MCTS) ? 1 : principalVariation(&contexts[0], sq, rec.pv);
+        rec.pv[0] = sq;
+    }
+    rec.ms = (float)(clockMs() - start);
+    unsigned head = __atomic_load_n(&telemetry_head, __ATOMIC_RELAXED);
+    if (head - __atomic_load_n(&telemetry_tail, __ATOMIC_ACQUIRE) >= TELEMETRY_RING)
+    {
+        telemetry_dropped++;
+        return;
+    }
+    telemetry_ring[head % TELEMETRY_RING] = rec;
+    __atomic_store_n(&telemetry_head, head + 1, __ATOMIC_RELEASE);
+}
+
+// 在根局面上依次走置换表里的最佳落子，表里没有或不合法就停，最后悔回根局面
+// 终局精确求解的表项用另一套键，空格少于 EXACT_TT_EMPTIES 时不进表，变例到那里为止
+int principalVariation(struct SearchContext *ctx, int sq, uint8_t *pv) {
+    uint64_t exact_key = exact_done ? zobrist_exact : 0;
+    int len = 0;
+    while (len < TELEMETRY_PV && sq >= 0)
+    {
+        pv[len++] = sq;
+        makeMove(ctx, sq);
+        struct TTInfo entry;
+        if (!ttProbe(ctx, ctx->hash_key ^ exact_key, &entry))
+            break;
+        sq = entry.move;
+        if (sq >= 0 && !bbTest(getMoves(ctx->discs[ctx->side], ctx->discs[ctx->side ^ 1]), sq))
+            break;
+    }
+    while (ctx->undo_top > 0)
+        unmakeMove(ctx);
+    return len;
+}
+
+void flushTelemetry() {
+    unsigned tail = __atomic_load_n(&telemetry_tail, __ATOMIC_RELAXED);
+    unsigned head = __atomic_load_n(&telemetry_head, __ATOMIC_ACQUIRE);
+    if (head == tail || !telemetry_path)
+        return;
+    FILE *fp = fopen(telemetry_path, "ab");
+    if (fp)
+    {
+        for (unsigned i = tail; i != head; i++)
+            fwrite(&telemetry_ring[i % TELEMETRY_RING], sizeof(struct TelemetryRecord), 1, fp);
+        fclose(fp);
+    }
+    __atomic_store_n(&telemetry_tail, head, __ATOMIC_RELEASE);
+}
+
+void exitTelemetry() {
+    stopPonder();
+    flushTelemetry();
+}
+
+// 排序分：置换表最佳落子 > 杀手着法 > 历史得分 + 格子权值
+int moveScore(struct SearchContext *ctx, int step, int sq, int tt_move) {
+    if (sq == tt_move)
+        return ORDER_TT;
+    if (sq == ctx->killer[step][0])
+        return ORDER_KILLER;
+    if (sq == ctx->killer[step][1])
+        return ORDER_KILLER - 1;
+    return ctx->history[ctx->side][sq] + sq_weight[sq];
+}
+
+// 剪枝着法记为本层杀手，并按剩余深度的平方累加历史得分
+void updateOrdering(struct SearchContext *ctx, int step, int sq, int depth) {
+    if (ctx->killer[step][0] != sq)
+    {
+        ctx->killer[step][1] = ctx->killer[step][0];
+        ctx->killer[step][0] = sq;
+    }
+    ctx->history[ctx->side][sq] += depth * depth;
+    if (ctx->history[ctx->side][sq] > HISTORY_LIMIT)
+        ageOrdering(ctx);
+}
+
+// 杀手着法只对当前这一步的搜索有意义，历史得分减半后继续沿用
+void ageOrdering(struct SearchContext *ctx) {
+    for (int i = 0; i < MAX_PLY; i++)
+        ctx->killer[i][0] = ctx->killer[i][1] = -1;
+    for (int c = 0; c < 2; c++)
+        for (int i = 0; i < MAX_CELLS; i++)
+            ctx->history[c][i] /= 2;
+}
+
+// 生成 Zobrist 随机数（固定种子的 splitmix64，每局结果一样）并清空置换表
+void initHash() {
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    uint64_t *keys[2 * MAX_CELLS + 3];
+    int n = 0;
+    for (int c = 0; c < 2; c++)
+        for (int i = 0; i < MAX_CELLS; i++)
+            keys[n++] = &zobrist[c][i];
+    keys[n++] = &zobrist_side;
+    keys[n++] = &zobrist_endgame;
+    keys[n++] = &zobrist_exact;
+    for (int i = 0; i < n; i++)
+    {
+        uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        *keys[i] = z ^ (z >> 31);
+    }
+    for (int i = 0; i < MAX_CELLS; i++)
+        zobrist_flip[i] = zobrist[0][i] ^ zobrist[1][i];
+    memset(tt, 0, sizeof(tt));
+    memset(contexts, 0, sizeof(contexts));
+    tt_generation = 0;
+    tt_probes = tt_hits = 0;
+}
+
+// 单调时钟
+double clockMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// 重新计算局面哈希
+uint64_t computeHash(struct SearchContext *ctx) {
+    uint64_t key = 0;
+    for (int c = 0; c < 2; c++)
+    {
+        struct BitBoard b = ctx->discs[c];
+        while (!bbEmpty(b))
+            key ^= zobrist[c][popLowest(&b)];
+    }
+    if (ctx->side)
+        key ^= zobrist_side;
+    if (endgame_weight)
+        key ^= zobrist_endgame;
+    return key;
+}
+
+// 解开置换表项
+inline void ttUnpack(uint64_t data, struct TTInfo *info) {
+    info->value = (int32_t)(uint32_t)data;
+    info->move = (int16_t)(uint16_t)(data >> 32);
+    info->depth = (uint8_t)(data >> 48);
+    info->bound = (data >> 56) & 3;
+    info->generation = (uint8_t)(data >> 58);
+}
+
+// 查置换表
+bool ttProbe(struct SearchContext *ctx, uint64_t key, struct TTInfo *info) {
+    struct TTBucket *bucket = &tt[key & ((1 << TT_BITS) - 1)];
+    ctx->tt_probes++;
+    for (int i = 0; i < TT_WAYS; i++)
+    {
+        uint64_t data = __atomic_load_n(&bucket->entry[i].data, __ATOMIC_RELAXED);
+        uint64_t check = __atomic_load_n(&bucket->entry[i].check, __ATOMIC_RELAXED);
+        if ((check ^ data) == key && (data >> 56) != 0)
+        {
+            ctx->tt_hits++;
+            ttUnpack(data, info);
+            return true;
         }
-        if (j == player->col_cnt)
-            colfull[i] = 1;
     }
-    // 检查所有对角线是否全为己方棋子
-    for (i = 0; i < player->col_cnt * 2 - 1; i++)
+    return false;
+}
+
+// 写置换表
+// 同一局面直接覆盖，否则替换空项，再否则替换旧代数中、深度最浅的项；
+// 两个线程同时写一项时可能一个字来自一次写入、一个字来自另一次，读的时候异或校验会把它筛掉
+void ttStore(uint64_t key, int depth, int bound, int value, int move) {
+    struct TTBucket *bucket = &tt[key & ((1 << TT_BITS) - 1)];
+    struct TTEntry *victim = NULL;
+    int victim_score = MAX;
+    for (int i = 0; i < TT_WAYS; i++)
+    {
+        struct TTEntry *e = &bucket->entry[i];
+        uint64_t data = __atomic_load_n(&e->data, __ATOMIC_RELAXED);
+        uint64_t check = __atomic_load_n(&e->check, __ATOMIC_RELAXED);
+        if ((check ^ data) == key || (data >> 56) == 0)
+        {
+            victim = e;
+            break;
+        }
+        struct TTInfo info;
+        ttUnpack(data, &info);
+        int score = (info.generation == tt_generation ? 256 : 0) + info.depth;
+        if (score < victim_score)
+        {
+            victim_score = score;
+            victim = e;
+        }
+    }
+    uint64_t data = (uint64_t)(uint32_t)value | (uint64_t)(uint16_t)move << 32 | (uint64_t)depth << 48
+                  | (uint64_t)(bound | (tt_generation << 2)) << 56;
+    __atomic_store_n(&victim->data, data, __ATOMIC_RELAXED);
+    __atomic_store_n(&victim->check, key ^ data, __ATOMIC_RELAXED);
+}
+
+// 终局得分差
+int finalScore(struct SearchContext *ctx) {
+    return ctx->terms.value[ctx->side] - ctx->terms.value[ctx->side ^ 1];
+}
+
+// 终局精确求解
+// 搜到棋局结束，按格子分值算最终得分差；走法排序：
+// 置换表最佳落子最先，其余优先走在空格数为奇数的象限里（抢到每块区域的最后一手），
+// 空格较多时再按落子后对方的行动力从少到多（fastest-first），对方选择越少剪枝越快
+template <int N>
+int solveExact(struct SearchContext *ctx, int step, int alpha, int beta) {
+    const int W = Geometry<N>::words;
+    struct Player *player = ctx->player;
+    ctx->nodes++;
+    if ((ctx->nodes & 255) == 0 && clockMs() > search_deadline)
+    {
+        __atomic_store_n(&search_abort, true, __ATOMIC_RELAXED);
+    }
+    if (searchStopped(ctx))
     {
-        int diacnt = player->col_cnt - abs((player->col_cnt * 2 - 2) / 2 - i);
-        int startx, starty;
-        // 主对角线
-        if (i < player->col_cnt - 1)
+        return 0;
+    }
+    struct BitBoard my = ctx->discs[ctx->side], opp = ctx->discs[ctx->side ^ 1];
+    struct BitBoard empty = bbAndNot<W>(full_board, bbOr<W>(my, opp));
+    int empties = bbCount<W>(empty);
+    if (empties == 0)
+    {
+        // 根结点棋盘已满时没有落子点，清掉上一次搜索留下的最优落子，place 才会返回 (-1, -1) 且不做后台思考
+        if (step == 1)
+            ctx->root_x = -1, ctx->root_y = -1;
+        return finalScore(ctx);
+    }
+    struct BitBoard moves = getMoves<N>(my, opp);
+    if (bbEmpty<W>(moves))
+    {
+        if (step == 1)
+        {
+            ctx->root_x = -1, ctx->root_y = -1;
+            return 0;
+        }
+        if (bbEmpty<W>(getMoves<N>(opp, my)))
         {
-            startx = player->col_cnt - 1 - i;
-            starty = 0;
+            return finalScore(ctx);
+        }
+        makeMove<N>(ctx, -1);
+        int value = -solveExact<N>(ctx, step + 1, -beta, -alpha);
+        unmakeMove<N>(ctx);
+        return value;
+    }
+    uint64_t key = ctx->hash_key ^ zobrist_exact;
+    int tt_move = -1;
+    if (empties >= EXACT_TT_EMPTIES)
+    {
+        struct TTInfo entry;
+        if (ttProbe(ctx, key, &entry))
+        {
+            tt_move = entry.move;
+            if (step > 1 && (entry.bound == BOUND_EXACT
+                || (entry.bound == BOUND_LOWER && entry.value >= beta)
+                || (entry.bound == BOUND_UPPER && entry.value <= alpha)))
+            {
+                return entry.value;
+            }
+        }
+    }
+    int odd_region = 0;
+    for (int q = 0; q < 4; q++)
+    {
+        if (bbCount<W>(bbAnd<W>(empty, quadrant[q])) & 1)
+            odd_region |= 1 << q;
+    }
+    int sq[MAX_CELLS], score[MAX_CELLS];
+    int n = 0;
+    while (!bbEmpty<W>(moves))
+    {
+        int s = popLowest<W>(&moves);
+        sq[n] = s;
+        score[n] = 0;
+        if (s == tt_move)
+        {
+            score[n] = ORDER_TT;
         }
         else
         {
-            startx = 0;
-            starty = i - player->col_cnt + 1;
+            for (int q = 0; q < 4; q++)
+            {
+                if ((odd_region >> q & 1) && bbTest(quadrant[q], s))
+                    score[n] += 64;
+            }
+            score[n] += cell_value[s];
+        }
+        n++;
+    }
+    // 落子后的子局面只复制位棋盘，成批地算对方的行动力
+    if (empties >= FASTEST_FIRST_EMPTIES)
+    {
+        struct EvalBatch batch;
+        for (int base = 0; base < n; base += EVAL_BATCH)
+        {
+            batch.n = 0;
+            for (int i = base; i < n && i < base + EVAL_BATCH; i++)
+            {
+                struct BitBoard flips = getFlips<N>(sq[i], my, opp);
+                struct BitBoard next = bbOr<W>(my, flips);
+                bbSet(&next, sq[i]);
+                batchAdd(&batch, bbAndNot<W>(opp, flips), next);
+            }
+            batchMobility<N>(&batch);
+            for (int i = base; i < n && i < base + EVAL_BATCH; i++)
+            {
+                if (score[i] != ORDER_TT)
+                    score[i] -= 16 * batch.moves[i - base];
+            }
         }
-        for (j = 0; j < diacnt; j++)
+    }
+    int alpha_orig = alpha;
+    int best_value = INF;
+    int best_sq = -1;
+    for (int i = 0; i < n; i++)
+    {
+        int pick = i;
+        for (int j = i + 1; j < n; j++)
         {
-            if (board[startx + j][starty + j] != 'O' && board[startx + j][starty + j] != 'o')
-                break;
+            if (score[j] > score[pick])
+                pick = j;
         }
-        if (j == diacnt)
-            diag1full[i] = 1;
-        // 副对角线
-        if (i < player->col_cnt - 1)
+        int t = sq[i]; sq[i] = sq[pick]; sq[pick] = t;
+        t = score[i]; score[i] = score[pick]; score[pick] = t;
+        makeMove<N>(ctx, sq[i]);
+        int value;
+        if (i == 0)
         {
-            startx = player->col_cnt - 1 - i;
-            starty = player->col_cnt - 1;
+            value = -solveExact<N>(ctx, step + 1, -beta, -alpha);
         }
         else
         {
-            startx = 0;
-            starty = 2 * player->col_cnt - 2 - i;
+            value = -solveExact<N>(ctx, step + 1, -alpha - 1, -alpha);
+            if (value > alpha && value < beta)
+            {
+                value = -solveExact<N>(ctx, step + 1, -beta, -alpha);
+            }
         }
-        for (j = 0; j < diacnt; j++)
+        unmakeMove<N>(ctx);
+        if (searchStopped(ctx))
         {
-            if (board[startx + j][starty - j] != 'O' && board[startx + j][starty - j] != 'o')
-                break;
+            return 0;
         }
-        if (j == diacnt)
-            diag2full[i] = 1;
-    }
-    // 检查内部稳定子（四个方向都被己方占满才算）
-    for (i = 1; i < player->col_cnt - 1; i++)
-    {
-        for (j = 1; j < player->col_cnt - 1; j++)
+        if (value > best_value)
         {
-            int diag1 = j - i + player->col_cnt - 1;
-            int diag2 = 2 * player->col_cnt - 2 - j - i;
-            if (board[i][j] == 'O' && colfull[j] && rowfull[i] && diag1full[diag1] && diag2full[diag2])
+            best_value = value;
+            best_sq = sq[i];
+            if (step == 1)
+            {
+                ctx->root_x = sq[i] / player->col_cnt;
+                ctx->root_y = sq[i] % player->col_cnt;
+            }
+            if (value > alpha)
             {
-                stable[2]++;
+                alpha = value;
+                if (alpha >= beta)
+                {
+                    ctx->cutoffs++;
+                    ctx->first_cutoffs += i == 0;
+                    break;
+                }
             }
         }
     }
-    // 返回所有稳定子数量
-    return stable[0] + stable[1] + stable[2];
+    if (empties >= EXACT_TT_EMPTIES)
+    {
+        int bound = best_value <= alpha_orig ? BOUND_UPPER : best_value >= beta ? BOUND_LOWER : BOUND_EXACT;
+        ttStore(key, empties, bound, best_value, best_sq);
+    }
+    return best_value;
 }
 
-// 落子并翻转棋子
-// 在(x, y)处落子，并将被夹住的对方棋子翻转为己方
-void applyMove(struct Player* player, int x, int y, char my_board[13][13], char opp_board[13][13]) {
-    my_board[x][y] = 'O';
-    opp_board[x][y] = 'o';
-    // 检查8个方向
-    for (int dir = 0; dir < 8; dir++)
+// 从池中分配 n 个连续结点，池满时返回 -1
+int mctsAlloc(int n) {
+    int first = __atomic_fetch_add(&mcts_used, n, __ATOMIC_RELAXED);
+    if (first + n > MCTS_NODES)
+        return -1;
+    for (int i = first; i < first + n; i++)
+    {
+        mcts_pool[i].first_child = -1;
+        mcts_pool[i].child_cnt = -1;
+        mcts_pool[i].move = -1;
+        mcts_pool[i].visits = 0;
+        mcts_pool[i].wins = 0;
+        mcts_pool[i].expanding = 0;
+    }
+    return first;
+}
+
+// 在 my 一方走第sq格（-1 为停一手），走完交换双方
+template <int N>
+inline void mctsPlay(struct BitBoard *my, struct BitBoard *opp, int sq) {
+    const int W = Geometry<N>::words;
+    if (sq >= 0)
+    {
+        struct BitBoard flips = getFlips<N>(sq, *my, *opp);
+        *my = bbOr<W>(*my, flips);
+        bbSet(my, sq);
+        *opp = bbAndNot<W>(*opp, flips);
+    }
+    struct BitBoard t = *my;
+    *my = *opp;
+    *opp = t;
+}
+
+// 一方占有格子的分值之和
+template <int W>
+inline int boardValue(struct BitBoard b) {
+    int total = 0;
+    for (int bit = 0; bit < 4; bit++)
+        total += bbCount<W>(bbAnd<W>(b, value_plane[bit])) << bit;
+    return total;
+}
+
+// 展开结点：每个合法落子一个子结点，无处可下时一个停一手的子结点，双方都无处可下为终局
+// 别的线程正在展开或池满时不展开，返回 false
+template <int N>
+bool mctsExpand(int node, struct BitBoard my, struct BitBoard opp) {
+    const int W = Geometry<N>::words;
+    struct MctsNode *n = &mcts_pool[node];
+    if (__atomic_exchange_n(&n->expanding, 1, __ATOMIC_ACQUIRE))
+        return false;
+    struct BitBoard moves = getMoves<N>(my, opp);
+    int cnt = bbCount<W>(moves);
+    if (cnt == 0 && bbEmpty<W>(getMoves<N>(opp, my)))
+    {
+        __atomic_store_n(&n->child_cnt, 0, __ATOMIC_RELEASE);
+        return true;
+    }
+    int first = mctsAlloc(cnt > 0 ? cnt : 1);
+    if (first < 0)
+        return false;
+    for (int i = 0; i < cnt; i++)
+        mcts_pool[first + i].move = popLowest<W>(&moves);
+    n->first_child = first;
+    __atomic_store_n(&n->child_cnt, cnt > 0 ? cnt : 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// 随机下到终局，返回起始时走棋一方的得分：胜 2、平 1、负 0
+template <int N>
+int mctsPlayout(struct SearchContext *ctx, struct BitBoard my, struct BitBoard opp) {
+    const int W = Geometry<N>::words;
+    int swapped = 0, passes = 0;
+    while (passes < 2)
     {
-        int nx = x + directions[dir][0];
-        int ny = y + directions[dir][1];
-        if (nx < 0 || nx >= player->row_cnt || ny < 0 || ny >= player->col_cnt)
+        struct BitBoard moves = getMoves<N>(my, opp);
+        int sq = -1;
+        if (bbEmpty<W>(moves))
         {
-            continue;
+            passes++;
         }
-        if (my_board[nx][ny] != 'o')
+        else
         {
-            continue;
+            passes = 0;
+            ctx->rng ^= ctx->rng << 13;
+            ctx->rng ^= ctx->rng >> 7;
+            ctx->rng ^= ctx->rng << 17;
+            int k = ctx->rng % bbCount<W>(moves);
+            sq = popLowest<W>(&moves);
+            while (k-- > 0)
+                sq = popLowest<W>(&moves);
+            ctx->nodes++;
+        }
+        mctsPlay<N>(&my, &opp, sq);
+        swapped ^= 1;
+    }
+    int diff = boardValue<W>(my) - boardValue<W>(opp);
+    if (swapped)
+        diff = -diff;
+    return diff > 0 ? 2 : diff == 0 ? 1 : 0;
+}
+
+// 一次模拟：按 UCT 从根结点选到未展开的结点，展开后选一个子结点随机下到终局，再把得分沿路加回去
+// 胜率按父结点走棋一方算，未访问过的子结点优先
+template <int N>
+void mctsIterate(struct SearchContext *ctx) {
+    struct BitBoard my = mcts_root_discs[0], opp = mcts_root_discs[1];
+    int path[MAX_PLY + 1];
+    int len = 0;
+    int node = mcts_root;
+    __atomic_fetch_add(&mcts_pool[node].visits, 1, __ATOMIC_RELAXED);
+    path[len++] = node;
+    bool can_expand = true; // 每次模拟只展开一层
+    while (len <= MAX_PLY)
+    {
+        struct MctsNode *n = &mcts_pool[node];
+        int cnt = __atomic_load_n(&n->child_cnt, __ATOMIC_ACQUIRE);
+        if (cnt < 0)
+        {
+            if (!can_expand || !mctsExpand<N>(node, my, opp))
+                break;
+            can_expand = false;
+            cnt = __atomic_load_n(&n->child_cnt, __ATOMIC_ACQUIRE);
         }
-        int x0 = nx, y0 = ny;
-        // 沿该方向查找是否能夹住对方棋子
-        while (true)
+        if (cnt == 0)
+            break;
+        int parent_visits = __atomic_load_n(&n->visits, __ATOMIC_RELAXED);
+        double log_visits = log((double)(parent_visits > 1 ? parent_visits : 1));
+        int pick = n->first_child;
+        double best = -1;
+        for (int c = n->first_child; c < n->first_child + cnt; c++)
         {
-            nx += directions[dir][0];
-            ny += directions[dir][1];
-            if (nx < 0 || nx >= player->row_cnt || ny < 0 || ny >= player->col_cnt || (my_board[nx][ny] >= '1' && my_board[nx][ny] <= '9'))
+            int visits = __atomic_load_n(&mcts_pool[c].visits, __ATOMIC_RELAXED);
+            if (visits == 0)
             {
+                pick = c;
                 break;
             }
-            if (my_board[nx][ny] == 'O')
+            double score = __atomic_load_n(&mcts_pool[c].wins, __ATOMIC_RELAXED) / (2.0 * visits) + MCTS_EXPLORE * sqrt(log_visits / visits);
+            if (score > best)
             {
-                // 夹住后，反向填充己方棋子
-                for (int i = x0, j = y0; i != nx || j != ny; i += directions[dir][0], j += directions[dir][1])
-                {
-                    my_board[i][j] = 'O';
-                    opp_board[i][j] = 'o';
-                }
-                break;
+                best = score;
+                pick = c;
             }
         }
+        node = pick;
+        __atomic_fetch_add(&mcts_pool[node].visits, 1, __ATOMIC_RELAXED);
+        path[len++] = node;
+        mctsPlay<N>(&my, &opp, mcts_pool[node].move);
+        ctx->nodes++;
+        if (!can_expand)
+            break;
+    }
+    // result 为 path[len - 1] 走棋一方的得分，每个结点记的是它父结点走棋一方的得分
+    int result = mctsPlayout<N>(ctx, my, opp);
+    for (int i = len - 1; i >= 0; i--)
+    {
+        result = 2 - result;
+        __atomic_fetch_add(&mcts_pool[path[i]].wins, result, __ATOMIC_RELAXED);
     }
+    ctx->playouts++;
 }
 
-// 复制棋盘
-// 将src棋盘复制到dest
-void copyBoard(int n, char dest[13][13], char src[13][13]) {
-    for (int i = 0; i < n; i++)
-        strcpy(dest[i], src[i]);
+// MCTS 线程：不断模拟，超时、叫停或固定次数用完时停下
+template <int N>
+void *mctsWorker(void *arg) {
+    struct SearchContext *ctx = (struct SearchContext *)arg;
+    while (!__atomic_load_n(&search_abort, __ATOMIC_RELAXED))
+    {
+        if (fixed_depth ? __atomic_fetch_sub(&mcts_budget, 1, __ATOMIC_RELAXED) <= 0 : clockMs() > search_deadline)
+        {
+            __atomic_store_n(&search_abort, true, __ATOMIC_RELAXED);
+            break;
+        }
+        mctsIterate<N>(ctx);
+    }
+    return NULL;
 }
 
-// 计算行动力差值
-// 返回己方可落子数-对方可落子数
-int getMobility(struct Player* player, char my_board[13][13], char opp_board[13][13]) {
-    int my_moves = 0, opp_moves = 0;
-    for (int i = 0; i < player->row_cnt; i++) {
-        for (int j = 0; j < player->col_cnt; j++) {
-            if (isValidMove(player, i, j, my_board)) my_moves++;
-            if (isValidMove(player, i, j, opp_board)) opp_moves++;
-        }
-    }
-    return my_moves - opp_moves;
-}
-
-// 计算当前局面权值
-// 只统计己方棋子权重总和，若一方无棋子直接返回极值
-int getBoardWeight(struct Player* player, char board[13][13]) {
-    int total_weight = 0, my_count = 0, opp_count = 0;
-    piece_count = 0;
-    for (int i = 0; i < player->row_cnt; i++) {
-        for (int j = 0; j < player->col_cnt; j++) {
-            if (board[i][j] == 'O') {
-                total_weight += weight[i][j];
-                my_count++;
-                piece_count++;
-            } else if (board[i][j] == 'o') {
-                opp_count++;
+// 准备根结点
+// 上一步的树里根结点之下两层（己方的落子、对方的落子或停一手）有当前局面就从那里接着搜，
+// 否则清空结点池；池用掉一半以上时也清空，免得搜到一半用完
+void mctsPrepare(struct BitBoard my, struct BitBoard opp) {
+    int root = -1;
+    if (mcts_root >= 0 && mcts_used < MCTS_NODES / 2)
+    {
+        const struct MctsNode *r = &mcts_pool[mcts_root];
+        for (int c = r->first_child; r->child_cnt > 0 && c < r->first_child + r->child_cnt && root < 0; c++)
+        {
+            const struct MctsNode *n = &mcts_pool[c];
+            struct BitBoard a = mcts_root_discs[0], b = mcts_root_discs[1];
+            mctsPlay<0>(&a, &b, n->move);
+            for (int g = n->first_child; n->child_cnt > 0 && g < n->first_child + n->child_cnt; g++)
+            {
+                struct BitBoard x = a, y = b;
+                mctsPlay<0>(&x, &y, mcts_pool[g].move);
+                if (memcmp(&x, &my, sizeof(my)) == 0 && memcmp(&y, &opp, sizeof(opp)) == 0)
+                {
+                    root = g;
+                    break;
+                }
             }
         }
     }
-    if (my_count == 0) return -100000;
-    if (opp_count == 0) return 1000000;
-    return total_weight;
+    if (root < 0)
+    {
+        mcts_used = 0;
+        root = mctsAlloc(1);
+    }
+    mcts_root = root;
+    mcts_root_discs[0] = my;
+    mcts_root_discs[1] = opp;
 }
 
-// 搜索主函数，极大极小搜索+剪枝
-int dfs(struct Player* player, int step, char my_board[13][13], char opp_board[13][13], int alpha_beta) {
-    // 搜索到最大深度，直接评估局面
-    if (step > SEARCH_DEPTH)
+// MCTS 主入口：各线程共用一棵树，结束后选访问次数最多的子结点
+void mctsSearch(struct Player *player, struct BitBoard my, struct BitBoard opp) {
+    for (int bit = 0; bit < 4; bit++)
     {
-        return getBoardWeight(player, my_board) + mobility_weight * getMobility(player, my_board, opp_board) + 10 * getStableDiscs(player, my_board) + endgame_weight * piece_count;
+        memset(&value_plane[bit], 0, sizeof(value_plane[bit]));
+        for (int sq = 0; sq < player->row_cnt * player->col_cnt; sq++)
+            if (cell_value[sq] >> bit & 1)
+                bbSet(&value_plane[bit], sq);
     }
-    int x[SEARCH_WIDTH + 1], y[SEARCH_WIDTH + 1];
-    for (int i = 0; i < SEARCH_WIDTH; i++)
+    mctsPrepare(my, opp);
+    mcts_budget = (long long)fixed_depth * MCTS_DEPTH_PLAYOUTS;
+    pthread_t workers[MAX_THREADS];
+    int worker_cnt = 0;
+    for (int t = 0; t < search_threads; t++)
     {
-        x[i] = y[i] = -1;
+        contexts[t].rng = 0x9E3779B97F4A7C15ULL * (t + 1) ^ mcts_used;
+        if (t > 0 && pthread_create(&workers[worker_cnt], NULL, search_entry.mctsWorker, &contexts[t]) == 0)
+            worker_cnt++;
     }
-    // 只保留权值最高的SEARCH_WIDTH个点进行扩展
-    for (int i = 0; i < player->row_cnt; i++)
+    search_entry.mctsWorker(&contexts[0]);
+    for (int t = 0; t < worker_cnt; t++)
+        pthread_join(workers[t], NULL);
+    // 沿访问最多的子结点一路往下，最后一层的深度当作搜索深度
+    best_x = best_y = -1;
+    last_depth = 0;
+    for (int node = mcts_root; mcts_pool[node].child_cnt > 0; last_depth++)
     {
-        for (int j = 0; j < player->row_cnt; j++)
+        const struct MctsNode *n = &mcts_pool[node];
+        int pick = n->first_child;
+        for (int c = n->first_child; c < n->first_child + n->child_cnt; c++)
+            if (mcts_pool[c].visits > mcts_pool[pick].visits)
+                pick = c;
+        if (mcts_pool[pick].visits == 0)
+            break;
+        if (node == mcts_root)
         {
-            if (isValidMove(player, i, j, my_board))
-            {
-                int k = SEARCH_WIDTH - 1;
-                while (k >= 0 && (x[k] == -1 || weight[i][j] > weight[x[k]][y[k]]))
-                {
-                    x[k + 1] = x[k];
-                    y[k + 1] = y[k];
-                    k--;
-                }
-                x[k + 1] = i;
-                y[k + 1] = j;
-            }
+            int sq = mcts_pool[pick].move;
+            best_x = sq < 0 ? -1 : sq / player->col_cnt;
+            best_y = sq < 0 ? -1 : sq % player->col_cnt;
         }
+        node = pick;
     }
-    // 无法落子，交换双方身份递归
-    if (x[0] == -1)
+}
+
+// 推算开局棋子的分值
+// 裁判给出的得分是己方占有格子的分值之和，减去已知格子的分值，
+// 若一方只占着一个分值未知的格子，剩下的就是这一格的分值
+void learnValues(struct Player* player, struct BitBoard my, struct BitBoard opp) {
+    int scores[2] = { player->your_score, player->opponent_score };
+    struct BitBoard sides[2] = { my, opp };
+    for (int c = 0; c < 2; c++)
     {
-        if (step == 1)
+        struct BitBoard unknown = bbAnd(sides[c], unknown_value);
+        if (bbCount(unknown) != 1)
+            continue;
+        int rest = scores[c];
+        struct BitBoard known = bbAndNot(sides[c], unknown_value);
+        while (!bbEmpty(known))
+            rest -= cell_value[popLowest(&known)];
+        if (rest >= 1 && rest <= 9)
         {
-            best_x = -1, best_y = -1;
-            return 0;
+            int s = popLowest(&unknown);
+            cell_value[s] = rest;
+            unknown_value.w[s >> 6] &= ~(1ULL << (s & 63));
         }
-        char next_mat[13][13];
-        char n_o_mat[13][13];
-        copyBoard(player->row_cnt, next_mat, my_board);
-        copyBoard(player->row_cnt, n_o_mat, opp_board);
-        if (step % 2 == 1)
+    }
+}
+
+// 判断是否合法落子
+int isValidMove(struct Player* player, int x, int y, struct BitBoard my, struct BitBoard opp) {
+    if (x < 0 || x >= player->row_cnt || y < 0 || y >= player->col_cnt)
+    {
+        return false;
+    }
+    int sq = x * player->col_cnt + y;
+    if (bbTest(my, sq) || bbTest(opp, sq))
+    {
+        return false;
+    }
+    return !bbEmpty(getFlips(sq, my, opp));
+}
+
+void initLineTables() {
+    if (line_tables_ready)
+        return;
+    for (int p = 0; p < MAX_LINE; p++)
+    {
+        for (int opp = 0; opp < 1 << MAX_LINE; opp++)
         {
-            return dfs(player, step + 1, n_o_mat, next_mat, INF);
+            int out = 0;
+            int k = p + 1;
+            while (k < MAX_LINE && (opp >> k & 1))
+                k++;
+            if (k > p + 1 && k < MAX_LINE)
+                out |= 1 << k;
+            k = p - 1;
+            while (k >= 0 && (opp >> k & 1))
+                k--;
+            if (k < p - 1 && k >= 0)
+                out |= 1 << k;
+            line_outflank[p][opp] = out;
         }
-        else
+        // 端点最多两个，一个在 p 之上一个在 p 之下，其余的下标用不到
+        for (int out = 0; out < 1 << MAX_LINE; out++)
         {
-            return dfs(player, step + 1, n_o_mat, next_mat, MAX);
+            int flipped = 0;
+            for (int k = p + 1; k < MAX_LINE && (out >> k) != 0; k++)
+                if (out >> k & 1)
+                    flipped |= ((1 << k) - 1) & ~((2 << p) - 1);
+            for (int k = p - 1; k >= 0; k--)
+                if (out >> k & 1)
+                {
+                    flipped |= ((1 << p) - 1) & ~((2 << k) - 1);
+                    break;
+                }
+            line_flipped[p][out] = flipped;
         }
     }
-    int ex_value;
-    if (step % 2 == 1)
+    line_tables_ready = true;
+}
+
+#if ENABLE_BMI2
+// 线上的格子位序号递增，pext 按位序号从低到高取出，各字取出的占位按 line_offset 拼起来正好是线上从头到尾的顺序
+template <int W>
+__attribute__((target("bmi2"))) struct BitBoard lineFlips(int sq, struct BitBoard my, struct BitBoard opp) {
+    struct BitBoard flips = { { 0 } };
+    for (int l = 0; l < 4; l++)
     {
-        ex_value = INF;
+        const struct BitBoard *mask = &line_mask[sq][l];
+        const uint8_t *offset = line_offset[sq][l];
+        int pos = sq_line_pos[sq][l];
+        int own_mask = 0, opp_mask = 0;
+        for (int w = 0; w < W; w++)
+        {
+            own_mask |= (int)_pext_u64(my.w[w], mask->w[w]) << offset[w];
+            opp_mask |= (int)_pext_u64(opp.w[w], mask->w[w]) << offset[w];
+        }
+        uint64_t f = line_flipped[pos][line_outflank[pos][opp_mask] & own_mask];
+        if (f)
+            for (int w = 0; w < W; w++)
+                flips.w[w] |= _pdep_u64(f >> offset[w], mask->w[w]);
     }
-    else
+    return flips;
+}
+#endif
+
+// 设置角落及其周围权值（角落周围格子权值较低，角落本身权值极高）
+void setCornerWeights(int x, int y) {
+    for (int i = 0; i < 2; i++)
+        for (int j = 0; j < 2; j++)
+            weight[x + i][y + j] = -25;
+}
+
+// 计算位棋盘的几何信息
+// 方向(dx, dy)的偏移为dx * col_cnt + dy，掩码保留移位后来源格子仍在棋盘内的位
+void initGeometry(struct Player* player) {
+    int row = player->row_cnt;
+    int col = player->col_cnt;
+    memset(&full_board, 0, sizeof(full_board));
+    for (int i = 0; i < row * col; i++)
+        bbSet(&full_board, i);
+    for (int dir = 0; dir < 8; dir++)
     {
-        ex_value = MAX;
+        int dx = directions[dir][0], dy = directions[dir][1];
+        dir_shift[dir] = dx * col + dy;
+        memset(&dir_mask[dir], 0, sizeof(dir_mask[dir]));
+        for (int i = 0; i < row; i++)
+            for (int j = 0; j < col; j++)
+                if (i - dx >= 0 && i - dx < row && j - dy >= 0 && j - dy < col)
+                    bbSet(&dir_mask[dir], i * col + j);
     }
-    // 极大极小搜索+剪枝
-    for (int i = 0; i < SEARCH_WIDTH && x[i] != -1; i++)
-    {
-        char next_mat[13][13];
-        char n_o_mat[13][13];
-        copyBoard(player->row_cnt, next_mat, my_board);
-        copyBoard(player->row_cnt, n_o_mat, opp_board);
-        applyMove(player, x[i], y[i], next_mat, n_o_mat);
-        int value = dfs(player, step + 1, n_o_mat, next_mat, ex_value);
-        if (step % 2 == 1)
+    // 相对的两个方向有一个移不进来的格子就在线的一端
+    for (int k = 0; k < 4; k++)
+        line_end[k] = bbAndNot(full_board, bbAnd(dir_mask[2 * k], dir_mask[2 * k + 1]));
+    // 一条线最长 max(row, col) 格，扩散的总步数要够从一端到另一端
+    int line_len = row > col ? row : col;
+    spread_cnt = 0;
+    for (int reach = 0, len = 1; reach < line_len - 1; reach += len, len = len < 4 ? len * 2 : 4)
+        spread_len[spread_cnt++] = len;
+    for (int dir = 0; dir < 8; dir++)
+        for (int t = 0; t < spread_cnt; t++)
         {
-            if (value > alpha_beta)
-            {
-                return MAX; // 剪枝
-            }
-            if (value > ex_value)
+            int dx = directions[dir][0] * spread_len[t], dy = directions[dir][1] * spread_len[t];
+            memset(&spread_mask[dir][t], 0, sizeof(spread_mask[dir][t]));
+            for (int i = 0; i < row; i++)
+                for (int j = 0; j < col; j++)
+                    if (i - dx >= 0 && i - dx < row && j - dy >= 0 && j - dy < col)
+                        bbSet(&spread_mask[dir][t], i * col + j);
+        }
+    // 查表翻转：四条线沿 directions 的第 0、2、4、6 个方向，位序号递增，从反方向走到头就是线的第一格
+    initLineTables();
+    for (int l = 0; l < 4; l++)
+    {
+        int dx = directions[2 * l][0], dy = directions[2 * l][1];
+        for (int i = 0; i < row; i++)
+            for (int j = 0; j < col; j++)
             {
-                ex_value = value;
-                if (step == 1)
+                int sq = i * col + j, pos = 0;
+                while (i - (pos + 1) * dx >= 0 && i - (pos + 1) * dx < row && j - (pos + 1) * dy >= 0 && j - (pos + 1) * dy < col)
+                    pos++;
+                sq_line_pos[sq][l] = pos;
+                memset(&line_mask[sq][l], 0, sizeof(line_mask[sq][l]));
+                for (int x = i - pos * dx, y = j - pos * dy; x >= 0 && x < row && y >= 0 && y < col; x += dx, y += dy)
+                    bbSet(&line_mask[sq][l], x * col + y);
+                for (int w = 0, offset = 0; w < BB_WORDS; w++)
                 {
-                    best_x = x[i];
-                    best_y = y[i];
+                    line_offset[sq][l][w] = offset;
+                    offset += __builtin_popcountll(line_mask[sq][l].w[w]);
                 }
             }
-        }
-        else
+    }
+}
+
+// 搜索入口
+template <int N>
+void selectEntry() {
+    search_entry.searchIteration = searchIteration<N>;
+    search_entry.solveExact = solveExact<N>;
+    search_entry.helperMain = helperMain<N>;
+    search_entry.ponderMain = ponderMain<N>;
+    search_entry.mctsWorker = mctsWorker<N>;
+}
+
+// 放下估值模式
+// 第 t 个放法和对称变换的约定相同：t & 4 时转置，t & 1 时翻转行，t & 2 时翻转列
+void initPatterns(struct Player *player) {
+    int n = player->col_cnt;
+    pattern_cnt = 0;
+    memset(pattern_sq_cnt, 0, sizeof(pattern_sq_cnt));
+    pattern_size = 0;
+    for (int p = 0; p < PATTERN_COUNT; p++)
+    {
+        pattern_offset[p] = pattern_size;
+        int entries = 1;
+        for (int k = 0; k < pattern_shapes[p].len; k++)
+            entries *= 3;
+        pattern_size += entries;
+    }
+    if (player->row_cnt != n || n < 8)
+        return;
+    struct BitBoard placed[PATTERN_INSTANCES];
+    for (int p = 0; p < PATTERN_COUNT; p++)
+        for (int t = 0; t < MAX_SYMMETRY; t++)
         {
-            if (value < alpha_beta)
+            const struct PatternShape *shape = &pattern_shapes[p];
+            struct BitBoard cells = { { 0 } };
+            for (int k = 0; k < shape->len; k++)
             {
-                return INF; // 剪枝
+                int x = (t & 4) ? shape->cell[k][1] : shape->cell[k][0];
+                int y = (t & 4) ? shape->cell[k][0] : shape->cell[k][1];
+                if (t & 1) x = n - 1 - x;
+                if (t & 2) y = n - 1 - y;
+                pattern_cell[pattern_cnt][k] = x * n + y;
+                bbSet(&cells, x * n + y);
             }
-            if (value < ex_value)
+            bool repeated = false;
+            for (int i = 0; i < pattern_cnt && !repeated; i++)
+                repeated = pattern_shape[i] == p && memcmp(&placed[i], &cells, sizeof(cells)) == 0;
+            if (repeated || pattern_cnt == PATTERN_INSTANCES)
+                continue;
+            placed[pattern_cnt] = cells;
+            pattern_shape[pattern_cnt] = p;
+            pattern_base[pattern_cnt] = pattern_offset[p];
+            for (int k = 0, power = 1; k < shape->len; k++, power *= 3)
             {
-                ex_value = value;
+                int sq = pattern_cell[pattern_cnt][k];
+                if (pattern_sq_cnt[sq] < PATTERN_PER_SQ)
+                {
+                    pattern_sq[sq][pattern_sq_cnt[sq]].instance = pattern_cnt;
+                    pattern_sq[sq][pattern_sq_cnt[sq]].power = power;
+                    pattern_sq_cnt[sq]++;
+                }
             }
+            pattern_cnt++;
         }
+    // 4 个子为开局，之后按棋子数均分
+    int cells = n * n;
+    for (int count = 0; count <= cells; count++)
+    {
+        int stage = count <= 4 ? 0 : (count - 4) * PATTERN_STAGES / (cells - 3);
+        pattern_stage[count] = stage < PATTERN_STAGES ? stage : PATTERN_STAGES - 1;
     }
-    return ex_value;
 }
 
-// 判断是否合法落子
-int isValidMove(struct Player* player, int x, int y, char board[13][13]) {
-    if (x < 0 || x >= player->row_cnt || y < 0 || y >= player->col_cnt)
-    {
-        return false;
-    }
-    if (board[x][y] == 'o' || board[x][y] == 'O')
+// 读入模式表
+// 文件里只有走棋一方为 1 的一份，读入后再按数字 1、2 互换排出另一份
+void loadPatterns(struct Player *player) {
+    free(pattern_table);
+    pattern_table = NULL;
+    FILE *fp = NULL;
+    if (pattern_cnt > 0 && pattern_path)
     {
-        return false;
+        char path[256];
+        snprintf(path, sizeof(path), pattern_path, player->col_cnt);
+        fp = fopen(path, "rb");
     }
-    // 检查8个方向是否能夹住对方棋子
-    for (int dir = 0; dir < 8; dir++)
+    size_t n = (size_t)PATTERN_STAGES * pattern_size;
+    struct PatternHeader header;
+    if (fp && fread(&header, sizeof(header), 1, fp) == 1 && header.magic == PATTERN_MAGIC && header.version == PATTERN_VERSION &&
+        header.size == (uint32_t)player->col_cnt && header.stages == PATTERN_STAGES && header.entries == (uint64_t)pattern_size)
     {
-        int nx = x + directions[dir][0];
-        int ny = y + directions[dir][1];
-        if (nx < 0 || nx >= player->row_cnt || ny < 0 || ny >= player->col_cnt)
-        {
-            continue;
-        }
-        if (board[nx][ny] != 'o')
+        pattern_table = (int16_t *)malloc(sizeof(int16_t) * 2 * n);
+        if (fread(pattern_value_weight, sizeof(int16_t), PATTERN_STAGES, fp) != PATTERN_STAGES ||
+            fread(pattern_table, sizeof(int16_t), n, fp) != n)
         {
-            continue;
+            free(pattern_table);
+            pattern_table = NULL;
         }
-        while (true)
+    }
+    if (fp)
+        fclose(fp);
+    if (!pattern_table)
+    {
+        // 不用模式估值，落子时也不必更新索引
+        memset(pattern_sq_cnt, 0, sizeof(pattern_sq_cnt));
+        return;
+    }
+    int16_t *swapped = pattern_table + n;
+    for (int p = 0; p < PATTERN_COUNT; p++)
+    {
+        int entries = p + 1 < PATTERN_COUNT ? pattern_offset[p + 1] - pattern_offset[p] : pattern_size - pattern_offset[p];
+        for (int index = 0; index < entries; index++)
         {
-            nx += directions[dir][0];
-            ny += directions[dir][1];
-            if (nx < 0 || nx >= player->row_cnt || ny < 0 || ny >= player->col_cnt || (board[nx][ny] >= '1' && board[nx][ny] <= '9'))
-            {
-                break;
-            }
-            if (board[nx][ny] == 'O')
-            {
-                return true;
-            }
+            int other = 0;
+            for (int rest = index, power = 1; rest > 0; rest /= 3, power *= 3)
+                other += (rest % 3 == 0 ? 0 : 3 - rest % 3) * power;
+            for (int stage = 0; stage < PATTERN_STAGES; stage++)
+                swapped[stage * pattern_size + pattern_offset[p] + index] = pattern_table[stage * pattern_size + pattern_offset[p] + other];
         }
     }
-    return false;
 }
 
-// 设置角落及其周围权值（角落周围格子权值较低，角落本身权值极高）
-void setCornerWeights(int x, int y) {
-    for (int i = 0; i < 2; i++)
-        for (int j = 0; j < 2; j++)
-            weight[x + i][y + j] = -25;
+void loadProbCut(struct Player *player) {
+    probcut_depths = 0;
+    int cells = player->row_cnt * player->col_cnt;
+    for (int c = 0; c <= cells; c++)
+        probcut_stage[c] = c * PROBCUT_STAGES / (cells + 1);
+    if (!probcut_path || player->row_cnt != player->col_cnt)
+        return;
+    char path[256];
+    snprintf(path, sizeof(path), probcut_path, player->col_cnt);
+    FILE *fp = fopen(path, "rb");
+    if (!fp)
+        return;
+    struct ProbCutHeader header;
+    if (fread(&header, sizeof(header), 1, fp) == 1 && header.magic == PROBCUT_MAGIC && header.version == PROBCUT_VERSION &&
+        header.size == (uint32_t)player->col_cnt && header.stages == PROBCUT_STAGES && header.depths <= PROBCUT_MAX_DEPTH &&
+        header.pattern == (pattern_table != NULL))
+    {
+        bool ok = true;
+        for (int stage = 0; stage < PROBCUT_STAGES && ok; stage++)
+            ok = fread(probcut[stage], sizeof(struct ProbCut), header.depths + 1, fp) == header.depths + 1;
+        if (ok)
+            probcut_depths = header.depths;
+    }
+    fclose(fp);
+}
+
+int probcutShallow(int depth) {
+    int shallow = depth / 2;
+    return (depth - shallow) & 1 ? shallow - 1 : shallow;
 }
 
 // 初始化棋盘和权值表
 void init(struct Player* player) {
+    // 上一局的后台思考还在跑就先停下，下面要清空置换表
+    stopPonder();
+    ponder_move = -1;
+    mcts_root = -1;
+    // 上一局的搜索记录写出去，换一个对局编号
+    flushTelemetry();
+    if (!telemetry_registered)
+        telemetry_registered = atexit(exitTelemetry) == 0;
+    // 裁判的系统调用检查不许调 getpid，用地址随机化后的全局变量地址区分进程
+    telemetry_game = (uint64_t)clockMs() * 1000003 ^ (uint64_t)(uintptr_t)&telemetry_game << 24;
+    telemetry_ply = 0;
     // 复制棋盘
     for (int i = 0; i < player->row_cnt; i++)
         for (int j = 0; j < player->col_cnt; j++)
             board[i][j] = player->mat[i][j];
+    initGeometry(player);
+    // 常见的方形棋盘用编译期几何的特化版本，其余大小用通用版本
+    int side_len = player->row_cnt == player->col_cnt ? player->col_cnt : 0;
+    if (side_len == 8)
+        selectEntry<8>();
+    else if (side_len == 10)
+        selectEntry<10>();
+    else if (side_len == 12)
+        selectEntry<12>();
+    else
+        selectEntry<0>();
+    initHash();
+#if ENABLE_AVX2
+    if (!__builtin_cpu_supports("avx2"))
+        avx2_enabled = false;
+#endif
+#if ENABLE_BMI2
+    if (!__builtin_cpu_supports("bmi2"))
+        bmi2_enabled = false;
+#endif
+    if (search_threads <= 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        search_threads = cpus < 1 ? 1 : cpus > MAX_THREADS ? MAX_THREADS : (int)cpus;
+    }
     int row = player->row_cnt;
     int col = player->col_cnt;
     // 初始化权值表
@@ -469,11 +2536,184 @@ void init(struct Player* player) {
     }
     weight[0][2] = weight[0][col - 3] = weight[row - 1][2] = weight[row - 1][col - 3] = 10;
     weight[2][0] = weight[row - 3][0] = weight[2][col - 1] = weight[row - 3][col - 1] = 10;
+    for (int i = 0; i < row; i++)
+        for (int j = 0; j < col; j++)
+            sq_weight[i * col + j] = weight[i][j];
+    // 批量估值按位平面算权值和
+    weight_min = 0;
+    for (int sq = 0; sq < row * col; sq++)
+        if (sq_weight[sq] < weight_min)
+            weight_min = sq_weight[sq];
+    for (int bit = 0; bit < WEIGHT_PLANES; bit++)
+    {
+        memset(&weight_plane[bit], 0, sizeof(weight_plane[bit]));
+        for (int sq = 0; sq < row * col; sq++)
+            if ((sq_weight[sq] - weight_min) >> bit & 1)
+                bbSet(&weight_plane[bit], sq);
+    }
+    // 格子分值和象限
+    memset(&unknown_value, 0, sizeof(unknown_value));
+    memset(quadrant, 0, sizeof(quadrant));
+    for (int i = 0; i < row; i++)
+        for (int j = 0; j < col; j++)
+        {
+            int sq = i * col + j;
+            if (player->mat[i][j] >= '1' && player->mat[i][j] <= '9')
+            {
+                cell_value[sq] = player->mat[i][j] - '0';
+            }
+            else
+            {
+                cell_value[sq] = UNKNOWN_VALUE;
+                bbSet(&unknown_value, sq);
+            }
+            bbSet(&quadrant[(i >= row / 2) * 2 + (j >= col / 2)], sq);
+        }
+    initSymmetry(player);
+    initPatterns(player);
+    loadPatterns(player);
+    loadProbCut(player);
+    loadBook();
+}
+
+// 读入棋盘
+void readBoard(struct Player *player, struct BitBoard *my, struct BitBoard *opp) {
+    memset(my, 0, sizeof(*my));
+    memset(opp, 0, sizeof(*opp));
+    for (int i = 0; i < player->row_cnt; i++)
+        for (int j = 0; j < player->col_cnt; j++)
+        {
+            if (player->mat[i][j] == 'O')
+            {
+                bbSet(my, i * player->col_cnt + j);
+            }
+            else if (player->mat[i][j] == 'o')
+            {
+                bbSet(opp, i * player->col_cnt + j);
+            }
+        }
+}
+
+// 对称变换
+// 第 t 个变换先在 t & 4 时转置（只有方形棋盘可以），再在 t & 1 时翻转行、t & 2 时翻转列；
+// 变换后每格的分值都不变才可用。开局有棋子的格子看不到分值，只要求变过去的格子同样看不到
+void initSymmetry(struct Player *player) {
+    int row = player->row_cnt, col = player->col_cnt;
+#define CELL_CLASS(x, y) (player->mat[x][y] >= '1' && player->mat[x][y] <= '9' ? player->mat[x][y] : '#')
+    sym_cnt = 0;
+    for (int t = 0; t < MAX_SYMMETRY; t++)
+    {
+        if ((t & 4) && row != col)
+            continue;
+        bool valid = true;
+        for (int i = 0; i < row && valid; i++)
+            for (int j = 0; j < col && valid; j++)
+            {
+                int x = (t & 4) ? j : i, y = (t & 4) ? i : j;
+                if (t & 1) x = row - 1 - x;
+                if (t & 2) y = col - 1 - y;
+                valid = CELL_CLASS(i, j) == CELL_CLASS(x, y);
+                sym_sq[sym_cnt][i * col + j] = x * col + y;
+                sym_inv[sym_cnt][x * col + y] = i * col + j;
+            }
+        if (valid)
+            sym_cnt++;
+    }
+    // FNV-1a：可用的变换都保持分值格局不变，直接按原样哈希即可
+    map_key = 0xCBF29CE484222325ULL;
+    for (int i = 0; i < row; i++)
+        for (int j = 0; j <= col; j++)
+            map_key = (map_key ^ (uint8_t)(j < col ? CELL_CLASS(i, j) : '\n')) * 0x100000001B3ULL;
+#undef CELL_CLASS
+}
+
+// 规范化的局面哈希
+uint64_t bookKey(struct BitBoard my, struct BitBoard opp, int *sym) {
+    uint64_t best = 0;
+    for (int t = 0; t < sym_cnt; t++)
+    {
+        uint64_t key = map_key;
+        struct BitBoard b = my;
+        while (!bbEmpty(b))
+            key ^= zobrist[0][sym_sq[t][popLowest(&b)]];
+        b = opp;
+        while (!bbEmpty(b))
+            key ^= zobrist[1][sym_sq[t][popLowest(&b)]];
+        if (t == 0 || key < best)
+        {
+            best = key;
+            *sym = t;
+        }
+    }
+    return best;
+}
+
+// 映射开局库
+void loadBook() {
+    if (book || !book_path)
+        return;
+    int fd = open(book_path, O_RDONLY);
+    if (fd < 0)
+        return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(struct BookHeader))
+    {
+        void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED)
+        {
+            const struct BookHeader *header = (const struct BookHeader *)map;
+            if (header->magic == BOOK_MAGIC && header->version == BOOK_VERSION && header->check == zobrist[0][0] &&
+                header->pattern == (pattern_table != NULL) &&
+                sizeof(struct BookHeader) + header->count * sizeof(struct BookEntry) <= (uint64_t)st.st_size)
+            {
+                book_map = map;
+                book_map_size = st.st_size;
+                book = (const struct BookEntry *)(header + 1);
+                book_size = header->count;
+            }
+            else
+            {
+                munmap(map, st.st_size);
+            }
+        }
+    }
+    close(fd);
+}
+
+// 查开局库：二分查找规范化的哈希，库里的落子按同一个变换变回实际棋盘，再确认一次合法
+int bookProbe(struct BitBoard my, struct BitBoard opp, int *value) {
+    if (book_size == 0)
+        return -1;
+    int sym = 0;
+    uint64_t key = bookKey(my, opp, &sym);
+    long long lo = 0, hi = book_size - 1;
+    while (lo <= hi)
+    {
+        long long mid = (lo + hi) / 2;
+        if (book[mid].key == key)
+        {
+            if (book[mid].move < 0 || book[mid].move >= MAX_CELLS)
+                return -1;
+            int sq = sym_inv[sym][book[mid].move];
+            if (!bbTest(getMoves(my, opp), sq))
+                return -1;
+            *value = book[mid].value;
+            return sq;
+        }
+        if (book[mid].key < key)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+    return -1;
 }
 
 // 选择最佳落点（主入口，返回当前最优落子点）
 struct Point place(struct Player* player) {
-    char opp_board[13][13], my_board[13][13];
+    double start = clockMs();
+    // 先叫停后台思考，下面要改的全局量它都在用
+    stopPonder();
+    struct BitBoard my_board, opp_board;
     // 根据棋盘大小设置行动力权重
     if (player->col_cnt == 8)
     {
@@ -487,26 +2727,11 @@ struct Point place(struct Player* player) {
     {
         mobility_weight = 10;
     }
-    // 复制棋盘并交换己方/对方棋子符号
-    for (int i = 0; i < player->row_cnt; i++)
-        for (int j = 0; j < player->col_cnt; j++)
-        {
-            my_board[i][j] = player->mat[i][j];
-            if (player->mat[i][j] == 'O')
-            {
-                opp_board[i][j] = 'o';
-            }
-            else if (player->mat[i][j] == 'o')
-            {
-                opp_board[i][j] = 'O';
-            }
-            else
-            {
-                opp_board[i][j] = player->mat[i][j];
-            }
-        }
+    // 把棋盘转成双方的位棋盘
+    readBoard(player, &my_board, &opp_board);
+    ponder_hit = ponderHit(my_board, opp_board);
     // 统计当前棋盘棋子数
-    int chess = countDiscs(player, my_board);
+    int chess = countDiscs(bbOr(my_board, opp_board));
     // 终局时加大终局权重
     if (player->row_cnt * player->row_cnt - chess <= player->row_cnt)
     {
@@ -516,8 +2741,130 @@ struct Point place(struct Player* player) {
     {
         endgame_weight = 0;
     }
-    // 搜索最优解
-    dfs(player, 1, my_board, opp_board, MAX);
+    // 搜索最优解，每个线程从同一个局面出发
+    tt_generation = (tt_generation + 1) & 63;
+    for (int t = 0; t < search_threads; t++)
+    {
+        struct SearchContext *ctx = &contexts[t];
+        ctx->player = player;
+        ctx->discs[0] = my_board;
+        ctx->discs[1] = opp_board;
+        ctx->side = 0;
+        ctx->undo_top = 0;
+        ctx->hash_key = computeHash(ctx);
+        ctx->nodes = ctx->tt_probes = ctx->tt_hits = ctx->evals = ctx->playouts = 0;
+        ctx->cutoffs = ctx->first_cutoffs = ctx->probcuts = 0;
+        ageOrdering(ctx);
+    }
+    struct SearchContext *main_ctx = &contexts[0];
+    learnValues(player, my_board, opp_board);
+    // 格子分值学完之后再统计估值项
+    for (int t = 0; t < search_threads; t++)
+        initTerms(&contexts[t]);
+    // 迭代加深：每轮深度加一，超时中止的那一轮作废，用上一轮的结果
+    // 下一轮大约要花本轮时间的 ebf 倍（有效分支因子，棋盘越大越大，之后按实测更新），
+    // 预计来不及就不再开始；深度超过空格数后结果不会再变
+    search_deadline = fixed_depth ? 1e300 : start + TIME_LIMIT_MS - TIME_RESERVE_MS;
+    __atomic_store_n(&search_abort, false, __ATOMIC_RELAXED);
+    int empties = player->row_cnt * player->col_cnt - chess;
+    double ebf = player->col_cnt == 8 ? 2.5 : player->col_cnt == 10 ? 3.0 : 3.5;
+    double last_cost = 0;
+    best_x = best_y = -1;
+    exact_empties = 0;
+    exact_done = false;
+    // 开局库里有的局面直接照着下，省下的时间留给中局
+    int book_value = 0;
+    int book_sq = bookProbe(my_board, opp_board, &book_value);
+    book_hit = book_sq >= 0;
+    if (book_hit)
+    {
+        last_score = book_value;
+        last_depth = 0;
+        recordTelemetry(player, start, TELEMETRY_BOOK, book_sq);
+        if (ponder_enabled && !mcts_enabled && !fixed_depth)
+            startPonder(player, my_board, opp_board, book_sq);
+        return initPoint(book_sq / player->col_cnt, book_sq % player->col_cnt);
+    }
+    // 空格足够少时直接精确求解到终局，限时内解不完再退回迭代加深（只剩第一轮可用）
+    if (empties <= endgame_empties)
+    {
+        double begin = clockMs();
+        exact_empties = empties;
+        main_ctx->search_depth = empties;
+        search_entry.solveExact(main_ctx, 1, INF, MAX);
+        exact_ms = clockMs() - begin;
+        if (!searchStopped(main_ctx))
+        {
+            exact_done = true;
+            best_x = main_ctx->root_x;
+            best_y = main_ctx->root_y;
+            last_depth = empties;
+        }
+    }
+    // 中局改用 MCTS 时不再迭代加深
+    bool use_mcts = mcts_enabled && !exact_done;
+    if (use_mcts)
+    {
+        mctsSearch(player, my_board, opp_board);
+    }
+    bool timed_out = exact_empties > 0 && !exact_done;
+    pthread_t helpers[MAX_THREADS];
+    int helper_cnt = 0;
+    // 终局求解超时后 search_abort 已经置上，只剩主线程的第一轮可用，不再启动帮手线程
+    for (int t = 1; t < search_threads && !exact_done && !timed_out && !use_mcts; t++)
+    {
+        if (pthread_create(&helpers[helper_cnt], NULL, search_entry.helperMain, &contexts[t]) == 0)
+            helper_cnt++;
+    }
+    for (main_ctx->search_depth = 1; !exact_done && !use_mcts && main_ctx->search_depth <= empties && main_ctx->search_depth <= MAX_SEARCH_DEPTH; main_ctx->search_depth++)
+    {
+        double begin = clockMs();
+        int value = search_entry.searchIteration(main_ctx, last_score);
+        if (searchStopped(main_ctx))
+        {
+            timed_out = true;
+            break;
+        }
+        last_score = value;
+        depth_score[main_ctx->search_depth] = value;
+        best_x = main_ctx->root_x;
+        best_y = main_ctx->root_y;
+        last_depth = main_ctx->search_depth;
+        if (best_x == -1)
+        {
+            break;
+        }
+        double now = clockMs();
+        double cost = now - begin;
+        if (last_cost > 0.05 && cost / last_cost > 1.5)
+        {
+            ebf = cost / last_cost;
+        }
+        last_cost = cost;
+        if (fixed_depth ? main_ctx->search_depth >= fixed_depth : now + cost * ebf > search_deadline)
+        {
+            break;
+        }
+    }
+    // 主线程结束，叫停帮手线程，汇总统计
+    __atomic_store_n(&search_abort, true, __ATOMIC_RELAXED);
+    for (int t = 0; t < helper_cnt; t++)
+    {
+        pthread_join(helpers[t], NULL);
+    }
+    for (int t = 0; t < search_threads; t++)
+    {
+        search_nodes += contexts[t].nodes;
+        search_evals += contexts[t].evals;
+        search_playouts += contexts[t].playouts;
+        search_probcuts += contexts[t].probcuts;
+        tt_probes += contexts[t].tt_probes;
+        tt_hits += contexts[t].tt_hits;
+    }
+    int flags = (exact_done ? TELEMETRY_EXACT : 0) | (use_mcts ? TELEMETRY_MCTS : 0) | (timed_out ? TELEMETRY_TIMEOUT : 0);
+    recordTelemetry(player, start, flags, best_x < 0 ? -1 : best_x * player->col_cnt + best_y);
+    if (ponder_enabled && !mcts_enabled && !fixed_depth && best_x != -1)
+        startPonder(player, my_board, opp_board, best_x * player->col_cnt + best_y);
     struct Point best_point = initPoint(best_x, best_y);
     return best_point;
 }
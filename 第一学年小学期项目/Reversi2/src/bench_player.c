@@ -0,0 +1,123 @@
+/**
+ * @file bench_player.c
+ * @brief 本地测速：用 code/player.h 自对弈，统计每步的搜索结点数和耗时，不经过 judge
+ *
+ * 用法: ./bin/bench_player [-p 步数] [-d 深度] [-t 线程数] [-e 空格数] [-n] [-E] [-C] [-M] [-S] [-w 毫秒] [-P] data/map.txt [data/map1.txt ...]
+ * -d 固定每步的搜索深度、不计时，用于比较不同版本在相同深度下的结点数
+ * -t 搜索线程数，默认按 CPU 核数
+ * -e 终局精确求解的空格数门槛，每张图走完后按空格数列出求解用时；配合 -d 可以不限时求解
+ * -n 不用开局库，比较结点数时用
+ * -E 不用模式估值，改用手写的估值
+ * -C 不做 Multi-ProbCut
+ * -M 中局改用 MCTS，-d 时每步按深度 x 1000 次模拟
+ * -S 批量估值（终局求解的走法排序）不用 AVX2，翻转不查表，和标量版本比较
+ * -w 每步之后等待的毫秒数，这段时间里后台思考接着搜（自对弈时搜的正好是下一步的局面）；-P 关闭后台思考
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../code/player.h"
+#include "tool_util.h"
+
+int main(int argc, char **argv) {
+    int plies = 20;
+    int show_exact = 0;
+    int wait_ms = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:d:t:e:nECMSw:P")) != -1) {
+        if (opt == 'p') {
+            plies = atoi(optarg);
+        } else if (opt == 'd') {
+            fixed_depth = atoi(optarg);
+        } else if (opt == 't') {
+            search_threads = atoi(optarg);
+        } else if (opt == 'e') {
+            endgame_empties = atoi(optarg);
+            show_exact = 1;
+        } else if (opt == 'n') {
+            book_path = NULL;
+        } else if (opt == 'E') {
+            pattern_path = NULL;
+        } else if (opt == 'C') {
+            probcut_path = NULL;
+        } else if (opt == 'M') {
+            mcts_enabled = true;
+        } else if (opt == 'S') {
+            avx2_enabled = false;
+            bmi2_enabled = false;
+        } else if (opt == 'w') {
+            wait_ms = atoi(optarg);
+        } else if (opt == 'P') {
+            ponder_enabled = false;
+        } else {
+            fprintf(stderr, "Usage: %s [-p plies] [-d depth] [-t threads] [-e empties] [-n] [-E] [-C] [-M] [-S] [-w wait ms] [-P] map.txt ...\n", argv[0]);
+            return 1;
+        }
+    }
+    printf("%-16s %6s %5s %12s %10s %12s %12s %12s %8s %6s %7s   %s\n", "map", "plies", "book", "nodes", "ms", "nodes/s", "evals/s", "playouts/s", "tt hit", "depth", "max ms", "moves");
+    for (int m = optind; m < argc; m++) {
+        struct Player player;
+        if (loadMap(&player, argv[m])) {
+            fprintf(stderr, "failed to load %s\n", argv[m]);
+            return 1;
+        }
+        init(&player);
+        long long nodes = 0, evals = 0, playouts = 0;
+        double cost = 0, slowest = 0;
+        int depth_sum = 0;
+        // 按空格数统计终局求解：次数、完成次数、总用时、最长用时
+        int solves[MAX_CELLS] = { 0 }, solved[MAX_CELLS] = { 0 };
+        double solve_ms[MAX_CELLS] = { 0 }, solve_max[MAX_CELLS] = { 0 };
+        int played = 0, passes = 0, book_moves = 0;
+        char moves[4096] = "";
+        while (played < plies && passes < 2) {
+            long long before = search_nodes, evals_before = search_evals, playouts_before = search_playouts;
+            double start = nowMs();
+            struct Point p = place(&player);
+            double spent = nowMs() - start;
+            cost += spent;
+            if (spent > slowest)
+                slowest = spent;
+            depth_sum += last_depth;
+            book_moves += book_hit;
+            if (exact_empties > 0) {
+                solves[exact_empties]++;
+                solved[exact_empties] += exact_done;
+                solve_ms[exact_empties] += exact_ms;
+                if (exact_ms > solve_max[exact_empties])
+                    solve_max[exact_empties] = exact_ms;
+            }
+            nodes += search_nodes - before;
+            evals += search_evals - evals_before;
+            playouts += search_playouts - playouts_before;
+            if (p.X < 0) {
+                passes++;
+            } else {
+                passes = 0;
+                playMove(&player, p);
+                char buf[16];
+                snprintf(buf, sizeof(buf), " %c%d", 'a' + p.Y, p.X + 1);
+                strncat(moves, buf, sizeof(moves) - strlen(moves) - 1);
+            }
+            swapSide(&player);
+            played++;
+            if (wait_ms > 0)
+                usleep(wait_ms * 1000);
+        }
+        printf("%-16s %6d %5d %12lld %10.1f %12.0f %12.0f %12.0f %7.1f%% %6.1f %7.1f  %s\n", argv[m], played, book_moves, nodes, cost, cost > 0 ? nodes / cost * 1000 : 0.0,
+               cost > 0 ? evals / cost * 1000 : 0.0, cost > 0 ? playouts / cost * 1000 : 0.0,
+               tt_probes > 0 ? 100.0 * tt_hits / tt_probes : 0.0, played > 0 ? (double)depth_sum / played : 0.0, slowest, moves);
+        if (show_exact) {
+            printf("  %8s %7s %7s %10s %10s\n", "empties", "solves", "done", "avg ms", "max ms");
+            for (int e = MAX_CELLS - 1; e > 0; e--)
+                if (solves[e] > 0)
+                    printf("  %8d %7d %7d %10.2f %10.2f\n", e, solves[e], solved[e], solve_ms[e] / solves[e], solve_max[e]);
+        }
+        freeMap(&player);
+    }
+    return 0;
+}
@@ -0,0 +1,169 @@
+/**
+ * @file book_player.c
+ * @brief 离线建开局库：用 code/player.h 按固定深度搜索每张地图的开局，写出 data/book.bin
+ *
+ * 用法: ./bin/book_player [-p 步数] [-d 深度] [-o 输出文件] data/map.txt [data/map1.txt ...]
+ * 轮到自己时搜出最佳落子记进库里，只沿这一步往下展开；轮到对方时展开对方所有的合法落子。
+ * 先手、后手，以及开局时 'O' 和 'o' 互换的两种摆法都各建一遍；-p 为展开的总步数
+ * 库里的局面按对称变换规范化，换个次序走到的同一局面只搜一次
+ * 文件头记下建库时是否用的模式估值，各地图的估值要一致（都有或都没有 data/patternN.bin），否则不写库
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../code/player.h"
+#include "tool_util.h"
+
+#define SEEN_BITS 20 // 已搜局面的哈希集合共 2^20 格
+
+int max_plies = 8;
+struct BookEntry *entries;
+long long entry_cnt, entry_cap;
+uint64_t seen[1 << SEEN_BITS]; // 开放寻址，0 为空
+
+// 记下一个局面，已经有了返回 0
+int insertSeen(uint64_t key) {
+    if (key == 0)
+        key = 1;
+    for (size_t i = key & ((1 << SEEN_BITS) - 1);; i = (i + 1) & ((1 << SEEN_BITS) - 1)) {
+        if (seen[i] == key)
+            return 0;
+        if (seen[i] == 0) {
+            seen[i] = key;
+            return 1;
+        }
+    }
+}
+
+void addEntry(uint64_t key, int move, int value) {
+    if (entry_cnt == entry_cap) {
+        entry_cap = entry_cap ? entry_cap * 2 : 1024;
+        entries = (struct BookEntry *)realloc(entries, sizeof(struct BookEntry) * entry_cap);
+    }
+    entries[entry_cnt].key = key;
+    entries[entry_cnt].move = move;
+    entries[entry_cnt].value = value;
+    entry_cnt++;
+}
+
+// 从当前局面展开 ply 步之后的开局树，mine 表示轮到自己走
+void expand(struct Player *player, int ply, int mine) {
+    if (ply >= max_plies)
+        return;
+    struct BitBoard my, opp;
+    readBoard(player, &my, &opp);
+    struct BitBoard moves = getMoves(my, opp);
+    if (bbEmpty(moves)) {
+        if (!bbEmpty(getMoves(opp, my))) {
+            swapSide(player);
+            expand(player, ply + 1, !mine);
+            swapSide(player);
+        }
+        return;
+    }
+    char saved[13][16];
+    for (int i = 0; i < player->row_cnt; i++)
+        memcpy(saved[i], player->mat[i], player->col_cnt);
+    if (mine) {
+        int sym = 0;
+        uint64_t key = bookKey(my, opp, &sym);
+        // 同一局面在开局树里总在同一步数出现，搜过一次后面也展开过了
+        if (!insertSeen(key))
+            return;
+        struct Point p = place(player);
+        addEntry(key, sym_sq[sym][p.X * player->col_cnt + p.Y], last_score);
+        playMove(player, p);
+        swapSide(player);
+        expand(player, ply + 1, 0);
+    } else {
+        while (!bbEmpty(moves)) {
+            int sq = popLowest(&moves);
+            playMove(player, initPoint(sq / player->col_cnt, sq % player->col_cnt));
+            swapSide(player);
+            expand(player, ply + 1, 1);
+            for (int i = 0; i < player->row_cnt; i++)
+                memcpy(player->mat[i], saved[i], player->col_cnt);
+        }
+    }
+    for (int i = 0; i < player->row_cnt; i++)
+        memcpy(player->mat[i], saved[i], player->col_cnt);
+}
+
+int compareEntry(const void *a, const void *b) {
+    uint64_t x = ((const struct BookEntry *)a)->key, y = ((const struct BookEntry *)b)->key;
+    return x < y ? -1 : x > y;
+}
+
+int main(int argc, char **argv) {
+    const char *out = BOOK_FILE;
+    fixed_depth = 8;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:d:o:")) != -1) {
+        if (opt == 'p') {
+            max_plies = atoi(optarg);
+        } else if (opt == 'd') {
+            fixed_depth = atoi(optarg);
+        } else if (opt == 'o') {
+            out = optarg;
+        } else {
+            fprintf(stderr, "Usage: %s [-p plies] [-d depth] [-o book.bin] map.txt ...\n", argv[0]);
+            return 1;
+        }
+    }
+    // 建库时不读旧库，否则库里有的局面都不会重新搜索；建库的搜索不写搜索记录
+    book_path = NULL;
+    telemetry_path = NULL;
+    printf("%-16s %8s %10s %8s\n", "map", "entries", "ms", "sym");
+    int uses_pattern = -1;
+    for (int m = optind; m < argc; m++) {
+        struct Player player;
+        if (loadMap(&player, argv[m])) {
+            fprintf(stderr, "failed to load %s\n", argv[m]);
+            return 1;
+        }
+        init(&player);
+        if (uses_pattern >= 0 && uses_pattern != (pattern_table != NULL)) {
+            fprintf(stderr, "%s uses a different evaluation from the maps before it\n", argv[m]);
+            return 1;
+        }
+        uses_pattern = pattern_table != NULL;
+        long long before = entry_cnt;
+        double start = nowMs();
+        // 开局的摆法和先后手都由裁判决定，四种组合都建
+        for (int swapped = 0; swapped < 2; swapped++) {
+            expand(&player, 0, 1);
+            expand(&player, 0, 0);
+            swapSide(&player);
+        }
+        printf("%-16s %8lld %10.0f %8d\n", argv[m], entry_cnt - before, nowMs() - start, sym_cnt);
+        fflush(stdout);
+        freeMap(&player);
+    }
+    qsort(entries, entry_cnt, sizeof(struct BookEntry), compareEntry);
+    FILE *fp = fopen(out, "wb");
+    if (!fp) {
+        perror(out);
+        return 1;
+    }
+    struct BookHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = BOOK_MAGIC;
+    header.version = BOOK_VERSION;
+    header.check = zobrist[0][0];
+    header.count = entry_cnt;
+    header.pattern = uses_pattern > 0;
+    if (fwrite(&header, sizeof(header), 1, fp) != 1 ||
+        fwrite(entries, sizeof(struct BookEntry), entry_cnt, fp) != (size_t)entry_cnt) {
+        perror(out);
+        fclose(fp);
+        return 1;
+    }
+    fclose(fp);
+    printf("wrote %lld entries to %s, %s evaluation\n", entry_cnt, out, uses_pattern > 0 ? "pattern" : "hand-written");
+    free(entries);
+    return 0;
+}
@@ -20,6 +20,5 @@ int main(int argc, char *argv[]) {
     struct Player red;
     red.mat = NULL;
     _work(&red, &read_fd, &write_fd, playid);
-    free(score_mat);
     return 0;
 }
@@ -0,0 +1,386 @@
+/**
+ * @file match_player.c
+ * @brief 本地对战：进程内当裁判，让 code/player.h 和 code/computer.h 在 data/map*.txt 上成批对弈，不经过 judge
+ *
+ * 用法: ./bin/match_player [-g 对局数] [-r 随机开局步数] [-j 进程数] [-l 限时] [-w 毫秒] [-P] [-d 深度] [-t 线程数] [-e 空格数] [-n] [-E] [-C] [-M] data/map.txt ...
+ * -g 每张图的对局数，两局一组：同一个随机开局双方各执先一次，默认 20
+ * -r 开局先由裁判随机走几步，避免每局都一样，默认 4
+ * -j 同时对弈的进程数，默认按 CPU 核数；每局在一个子进程里跑，两个引擎的全局状态互不干扰
+ * -l 每步限时（毫秒），只统计超时次数，不判负，默认 100
+ * -w computer 每步之前等待的毫秒数，模拟对方思考，player 的后台思考在这段时间里搜；-P 关闭后台思考
+ * -d/-t/-e/-n/-E/-C/-M 调整 player.h：固定深度、搜索线程数（默认 1）、终局求解门槛、不用开局库、不用模式估值、不做 ProbCut、中局改用 MCTS
+ *
+ * 规则同裁判：夹住的对方棋子翻转，无处可下时停一手，双方都无处可下时结束；
+ * 得分为占有格子的分值之和，地图上看不到分值的开局格子按 0 分计。地图里的 'O' 归先手
+ */
+
+// 两个引擎都是整个头文件的全局代码，各自包进一个命名空间；
+// 它们用到的系统头文件和 playerbase.h 先在外面包含，命名空间里再包含时被头文件保护跳过
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#include <iostream>
+
+#include "../include/playerbase.h"
+
+namespace computer {
+#include "../code/computer.h"
+}
+
+namespace player {
+#include "../code/player.h"
+}
+
+#define MAX_MAPS 16
+#define ENGINE_PLAYER 0
+#define ENGINE_COMPUTER 1
+
+// 不链接 libplayer.a（其中的 _work 要求全局的 init/place），这里补上唯一用到的函数
+struct Point initPoint(int x, int y) {
+    struct Point p;
+    p.X = x;
+    p.Y = y;
+    return p;
+}
+
+// 一张地图
+struct Map {
+    const char *path;
+    int row_cnt, col_cnt;
+    char cell[13][16]; // 地图原样，'O' 为先手的棋子
+};
+
+// 一局的结果，子进程写进管道交给父进程汇总
+struct GameResult {
+    int map;
+    int game;
+    int score[2];      // 按引擎下标：ENGINE_PLAYER、ENGINE_COMPUTER
+    int moves[2];      // 实际落子次数
+    double total_ms[2];
+    double max_ms[2];
+    int over_limit[2]; // 超过限时的步数
+    int illegal;       // 走了不合法棋步的引擎，没有为 -1，走错的一方判负
+    int depth_sum;     // player 每步完成的搜索深度之和
+    int ponder_hits;   // player 的后台思考猜中对方落子的次数
+};
+
+struct Map maps[MAX_MAPS];
+int map_cnt;
+int games_per_map = 20;
+int random_plies = 4;
+double limit_ms = 100;
+int wait_ms = 0;
+
+// 读入地图文件：第一行为行数和列数，之后每行一个字符串
+int loadMap(struct Map *map, const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        perror(path);
+        return 1;
+    }
+    map->path = path;
+    if (fscanf(fp, "%d%d", &map->row_cnt, &map->col_cnt) != 2 || map->row_cnt > 13 || map->col_cnt > 13) {
+        fclose(fp);
+        return 1;
+    }
+    for (int i = 0; i < map->row_cnt; i++) {
+        if (fscanf(fp, "%15s", map->cell[i]) != 1) {
+            fclose(fp);
+            return 1;
+        }
+    }
+    fclose(fp);
+    return 0;
+}
+
+double nowMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// 对局状态：owner 为 -1 表示空格，否则为占有该格的引擎
+struct Game {
+    const struct Map *map;
+    int owner[13][13];
+};
+
+// 引擎 e 在 (x, y) 落子会翻转的棋子数，flip 非 0 时真的翻转
+int playAt(struct Game *g, int e, int x, int y, int flip) {
+    static const int dx[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+    static const int dy[8] = { 1, -1, 0, 0, 1, -1, -1, 1 };
+    int row = g->map->row_cnt, col = g->map->col_cnt;
+    if (x < 0 || x >= row || y < 0 || y >= col || g->owner[x][y] != -1)
+        return 0;
+    int total = 0;
+    for (int d = 0; d < 8; d++) {
+        int cx = x + dx[d], cy = y + dy[d], n = 0;
+        while (cx >= 0 && cx < row && cy >= 0 && cy < col && g->owner[cx][cy] == 1 - e) {
+            cx += dx[d];
+            cy += dy[d];
+            n++;
+        }
+        if (n == 0 || cx < 0 || cx >= row || cy < 0 || cy >= col || g->owner[cx][cy] != e)
+            continue;
+        total += n;
+        if (flip)
+            for (cx -= dx[d], cy -= dy[d]; cx != x || cy != y; cx -= dx[d], cy -= dy[d])
+                g->owner[cx][cy] = e;
+    }
+    if (flip && total > 0)
+        g->owner[x][y] = e;
+    return total;
+}
+
+// 引擎 e 的所有合法落子，返回个数
+int legalMoves(struct Game *g, int e, int xs[], int ys[]) {
+    int n = 0;
+    for (int i = 0; i < g->map->row_cnt; i++)
+        for (int j = 0; j < g->map->col_cnt; j++)
+            if (playAt(g, e, i, j, 0) > 0) {
+                xs[n] = i;
+                ys[n] = j;
+                n++;
+            }
+    return n;
+}
+
+int score(struct Game *g, int e) {
+    int total = 0;
+    for (int i = 0; i < g->map->row_cnt; i++)
+        for (int j = 0; j < g->map->col_cnt; j++) {
+            char c = g->map->cell[i][j];
+            if (g->owner[i][j] == e && c >= '1' && c <= '9')
+                total += c - '0';
+        }
+    return total;
+}
+
+// 按引擎 e 的视角填好 mat：自己的棋子为 'O'，对方为 'o'，空格为分值
+void fillView(struct Game *g, int e, struct Player *view) {
+    for (int i = 0; i < g->map->row_cnt; i++)
+        for (int j = 0; j < g->map->col_cnt; j++) {
+            int o = g->owner[i][j];
+            view->mat[i][j] = o == -1 ? g->map->cell[i][j] : o == e ? 'O' : 'o';
+        }
+    view->your_score = score(g, e);
+    view->opponent_score = score(g, 1 - e);
+}
+
+// 下一局：第 game / 2 组随机开局，game 为偶数时 player 先手
+void playGame(int m, int game, struct GameResult *r) {
+    struct Game g;
+    g.map = &maps[m];
+    int first = game % 2 == 0 ? ENGINE_PLAYER : ENGINE_COMPUTER;
+    for (int i = 0; i < g.map->row_cnt; i++)
+        for (int j = 0; j < g.map->col_cnt; j++) {
+            char c = g.map->cell[i][j];
+            g.owner[i][j] = c == 'O' ? first : c == 'o' ? 1 - first : -1;
+        }
+    memset(r, 0, sizeof(*r));
+    r->map = m;
+    r->game = game;
+    r->illegal = -1;
+    struct Player views[2];
+    for (int e = 0; e < 2; e++) {
+        views[e].row_cnt = g.map->row_cnt;
+        views[e].col_cnt = g.map->col_cnt;
+        views[e].mat = (char **)malloc(sizeof(char *) * g.map->row_cnt);
+        for (int i = 0; i < g.map->row_cnt; i++)
+            views[e].mat[i] = (char *)calloc(g.map->col_cnt + 2, 1);
+        fillView(&g, e, &views[e]);
+    }
+    player::init(&views[ENGINE_PLAYER]);
+    computer::init(&views[ENGINE_COMPUTER]);
+    unsigned seed = (unsigned)(m * 100003 + game / 2 * 7919 + 1);
+    int xs[169], ys[169];
+    int side = first, passes = 0;
+    for (int ply = 0; passes < 2; ply++, side = 1 - side) {
+        int n = legalMoves(&g, side, xs, ys);
+        if (n == 0) {
+            passes++;
+            continue;
+        }
+        passes = 0;
+        struct Point p;
+        if (ply < random_plies) {
+            int k = rand_r(&seed) % n;
+            p = initPoint(xs[k], ys[k]);
+        } else {
+            fillView(&g, side, &views[side]);
+            if (side == ENGINE_COMPUTER && wait_ms > 0)
+                usleep(wait_ms * 1000);
+            double start = nowMs();
+            p = side == ENGINE_PLAYER ? player::place(&views[side]) : computer::place(&views[side]);
+            double spent = nowMs() - start;
+            r->moves[side]++;
+            r->total_ms[side] += spent;
+            if (spent > r->max_ms[side])
+                r->max_ms[side] = spent;
+            r->over_limit[side] += spent > limit_ms;
+            if (side == ENGINE_PLAYER) {
+                r->depth_sum += player::last_depth;
+                r->ponder_hits += player::ponder_hit;
+            }
+        }
+        if (playAt(&g, side, p.X, p.Y, 1) == 0) {
+            r->illegal = side;
+            break;
+        }
+    }
+    r->score[ENGINE_PLAYER] = score(&g, ENGINE_PLAYER);
+    r->score[ENGINE_COMPUTER] = score(&g, ENGINE_COMPUTER);
+    for (int e = 0; e < 2; e++) {
+        for (int i = 0; i < g.map->row_cnt; i++)
+            free(views[e].mat[i]);
+        free(views[e].mat);
+    }
+}
+
+// 汇总一张图（或全部，map 为 -1）的结果
+void report(const char *name, struct GameResult *results, int n, int map) {
+    int games = 0, win = 0, draw = 0, loss = 0, illegal[2] = { 0, 0 }, over[2] = { 0, 0 }, moves[2] = { 0, 0 };
+    int depth_sum = 0, ponder_hits = 0;
+    double margin = 0, total_ms[2] = { 0, 0 }, max_ms[2] = { 0, 0 };
+    for (int i = 0; i < n; i++) {
+        struct GameResult *r = &results[i];
+        if (map >= 0 && r->map != map)
+            continue;
+        games++;
+        int diff = r->score[ENGINE_PLAYER] - r->score[ENGINE_COMPUTER];
+        if (r->illegal >= 0) {
+            illegal[r->illegal]++;
+            diff = r->illegal == ENGINE_PLAYER ? -1 : 1;
+        }
+        win += diff > 0;
+        draw += diff == 0;
+        loss += diff < 0;
+        margin += r->illegal >= 0 ? 0 : r->score[ENGINE_PLAYER] - r->score[ENGINE_COMPUTER];
+        depth_sum += r->depth_sum;
+        ponder_hits += r->ponder_hits;
+        for (int e = 0; e < 2; e++) {
+            moves[e] += r->moves[e];
+            total_ms[e] += r->total_ms[e];
+            over[e] += r->over_limit[e];
+            if (r->max_ms[e] > max_ms[e])
+                max_ms[e] = r->max_ms[e];
+        }
+    }
+    if (games == 0)
+        return;
+    printf("%-16s %6d %5d %5d %5d %7.1f%% %8.1f %8.2f %8.1f %5d %7.1f %7.1f%% %8.2f %8.1f %5d %5d %5d\n", name, games, win, draw, loss,
+           100.0 * (win + 0.5 * draw) / games, margin / games, moves[0] ? total_ms[0] / moves[0] : 0.0, max_ms[0], over[0],
+           moves[0] ? (double)depth_sum / moves[0] : 0.0, moves[0] ? 100.0 * ponder_hits / moves[0] : 0.0,
+           moves[1] ? total_ms[1] / moves[1] : 0.0, max_ms[1], over[1], illegal[0], illegal[1]);
+}
+
+int main(int argc, char **argv) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int jobs = cpus < 1 ? 1 : (int)cpus;
+    player::search_threads = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "g:r:j:l:w:Pd:t:e:nECM")) != -1) {
+        if (opt == 'g') {
+            games_per_map = atoi(optarg);
+        } else if (opt == 'r') {
+            random_plies = atoi(optarg);
+        } else if (opt == 'j') {
+            jobs = atoi(optarg);
+        } else if (opt == 'l') {
+            limit_ms = atof(optarg);
+        } else if (opt == 'w') {
+            wait_ms = atoi(optarg);
+        } else if (opt == 'P') {
+            player::ponder_enabled = false;
+        } else if (opt == 'd') {
+            player::fixed_depth = atoi(optarg);
+        } else if (opt == 't') {
+            player::search_threads = atoi(optarg);
+        } else if (opt == 'e') {
+            player::endgame_empties = atoi(optarg);
+        } else if (opt == 'n') {
+            player::book_path = NULL;
+        } else if (opt == 'E') {
+            player::pattern_path = NULL;
+        } else if (opt == 'C') {
+            player::probcut_path = NULL;
+        } else if (opt == 'M') {
+            player::mcts_enabled = true;
+        } else {
+            fprintf(stderr, "Usage: %s [-g games] [-r random plies] [-j jobs] [-l limit ms] [-w wait ms] [-P] [-d depth] [-t threads] [-e empties] [-n] [-E] [-C] [-M] map.txt ...\n", argv[0]);
+            return 1;
+        }
+    }
+    if (jobs < 1 || games_per_map < 1 || optind == argc) {
+        fprintf(stderr, "Usage: %s [-g games] [-r random plies] [-j jobs] [-l limit ms] [-w wait ms] [-P] [-d depth] [-t threads] [-e empties] [-n] [-E] [-C] [-M] map.txt ...\n", argv[0]);
+        return 1;
+    }
+    for (int m = optind; m < argc && map_cnt < MAX_MAPS; m++) {
+        if (loadMap(&maps[map_cnt], argv[m])) {
+            fprintf(stderr, "failed to load %s\n", argv[m]);
+            return 1;
+        }
+        map_cnt++;
+    }
+    int total = map_cnt * games_per_map;
+    // 所有子进程往同一个管道里写结果，每条都小于 PIPE_BUF，写入是原子的
+    int fds[2];
+    if (pipe(fds) != 0) {
+        perror("pipe");
+        return 1;
+    }
+    fflush(stdout);
+    for (int w = 0; w < jobs && w < total; w++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return 1;
+        }
+        if (pid == 0) {
+            close(fds[0]);
+            // 每局再分一个子进程，两个引擎每局都从干净的全局状态开始
+            for (int k = w; k < total; k += jobs) {
+                pid_t game = fork();
+                if (game == 0) {
+                    struct GameResult r;
+                    playGame(k / games_per_map, k % games_per_map, &r);
+                    if (write(fds[1], &r, sizeof(r)) != (ssize_t)sizeof(r))
+                        _exit(1);
+                    _exit(0);
+                }
+                if (game > 0)
+                    waitpid(game, NULL, 0);
+            }
+            _exit(0);
+        }
+    }
+    close(fds[1]);
+    struct GameResult *results = (struct GameResult *)malloc(sizeof(struct GameResult) * total);
+    int done = 0;
+    while (done < total && read(fds[0], &results[done], sizeof(struct GameResult)) == (ssize_t)sizeof(struct GameResult))
+        done++;
+    while (wait(NULL) > 0)
+        ;
+    printf("%-16s %6s %5s %5s %5s %8s %8s %8s %8s %5s %7s %8s %8s %8s %5s %5s %5s\n", "map", "games", "win", "draw", "loss", "rate",
+           "margin", "p avg", "p max", "p>lim", "depth", "ponder", "c avg", "c max", "c>lim", "p ill", "c ill");
+    for (int m = 0; m < map_cnt; m++)
+        report(maps[m].path, results, done, m);
+    report("total", results, done, -1);
+    if (done < total)
+        printf("%d of %d games did not report\n", total - done, total);
+    free(results);
+    return done < total;
+}
@@ -0,0 +1,363 @@
+/**
+ * @file perft_player.c
+ * @brief 走法生成的正确性和速度测试：从每张地图的开局出发数到第 N 步的叶子数
+ *
+ * 用法: ./bin/perft_player [-D 最大深度] data/map.txt [data/map1.txt ...]
+ * 同一棵树用五种走法生成各数一遍，叶子数对不上就报错并返回非 0：
+ *   char     逐格逐方向扫描字符棋盘，落子时复制整个棋盘，即位棋盘之前的做法，作为参照
+ *   computer code/computer.h 的 is_valid 判断合法，翻转同 char
+ *   generic  code/player.h 运行期几何的 getMoves 和 makeMove/unmakeMove，关掉查表，翻转沿八个方向移位
+ *   bitboard 同上，8x8、10x10、12x12 用按棋盘大小特化的版本，CPU 支持 BMI2 时 10x10 以上查表翻转，即搜索实际用的版本
+ *   line     code/player.h 的 lineFlips 逐个空格查表求翻转，子结点复制位棋盘；CPU 不支持 BMI2 时不数
+ * 无处可下时停一手也算一步，双方都无处可下时局面算一个叶子
+ * 每张图最后把最深一层的叶子局面（至多 BATCH_POSITIONS 个）逐个估值一遍作参照，再用 evaluateBatch
+ * 按标量和 AVX2 各算一遍，四项结果对不上就报错，并列出每秒估值的局面数
+ */
+
+// 两个引擎各自包进一个命名空间，做法同 match_player.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#include <iostream>
+
+#include "../include/playerbase.h"
+
+namespace computer {
+#include "../code/computer.h"
+}
+
+namespace player {
+#include "../code/player.h"
+}
+
+#define BOARD_COLS 30 // 与 computer.h 的 is_valid 的棋盘列数一致
+#define BATCH_POSITIONS (1 << 17) // 批量估值测试取的叶子局面数上限
+
+struct Point initPoint(int x, int y) {
+    struct Point p;
+    p.X = x;
+    p.Y = y;
+    return p;
+}
+
+int row_cnt, col_cnt;
+long long visited; // 本次计数访问的结点数（含内部结点），用于算速度
+
+double nowMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// 在字符棋盘上为 my 一方落子，返回翻转的棋子数；flip 为 0 时只判断
+int charPlay(char b[][BOARD_COLS], int x, int y, char my, char his, int flip) {
+    static const int dx[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+    static const int dy[8] = { 1, -1, 0, 0, 1, -1, -1, 1 };
+    if (b[x][y] == my || b[x][y] == his)
+        return 0;
+    int total = 0;
+    for (int d = 0; d < 8; d++) {
+        int cx = x + dx[d], cy = y + dy[d], n = 0;
+        while (cx >= 0 && cx < row_cnt && cy >= 0 && cy < col_cnt && b[cx][cy] == his) {
+            cx += dx[d];
+            cy += dy[d];
+            n++;
+        }
+        if (n == 0 || cx < 0 || cx >= row_cnt || cy < 0 || cy >= col_cnt || b[cx][cy] != my)
+            continue;
+        total += n;
+        if (!flip)
+            return total;
+        for (cx -= dx[d], cy -= dy[d]; cx != x || cy != y; cx -= dx[d], cy -= dy[d])
+            b[cx][cy] = my;
+    }
+    if (flip && total > 0)
+        b[x][y] = my;
+    return total;
+}
+
+// 参照实现：逐格判断，子结点各复制一份棋盘；use_computer 时改用 computer.h 判断合法
+long long perftChar(char b[][BOARD_COLS], char my, char his, int depth, int passed, int use_computer) {
+    visited++;
+    if (depth == 0)
+        return 1;
+    long long leaves = 0;
+    int moves = 0;
+    for (int i = 0; i < row_cnt; i++)
+        for (int j = 0; j < col_cnt; j++) {
+            bool legal = use_computer ? computer::is_valid(row_cnt, col_cnt, b, i, j, my, his) != 0 : charPlay(b, i, j, my, his, 0) > 0;
+            if (!legal)
+                continue;
+            moves++;
+            char child[13][BOARD_COLS];
+            memcpy(child, b, sizeof(child));
+            charPlay(child, i, j, my, his, 1);
+            leaves += perftChar(child, his, my, depth - 1, 0, use_computer);
+        }
+    if (moves == 0)
+        return passed ? 1 : perftChar(b, his, my, depth - 1, 1, use_computer);
+    return leaves;
+}
+
+// 位棋盘：原地落子和悔棋，N 为 0 时用运行期几何
+template <int N>
+long long perftBitboard(struct player::SearchContext *ctx, int depth, int passed) {
+    visited++;
+    if (depth == 0)
+        return 1;
+    struct player::BitBoard moves = player::getMoves<N>(ctx->discs[ctx->side], ctx->discs[ctx->side ^ 1]);
+    if (player::bbEmpty(moves)) {
+        if (passed)
+            return 1;
+        player::makeMove<N>(ctx, -1);
+        long long leaves = perftBitboard<N>(ctx, depth - 1, 1);
+        player::unmakeMove<N>(ctx);
+        return leaves;
+    }
+    long long leaves = 0;
+    while (!player::bbEmpty(moves)) {
+        player::makeMove<N>(ctx, player::popLowest(&moves));
+        leaves += perftBitboard<N>(ctx, depth - 1, 0);
+        player::unmakeMove<N>(ctx);
+    }
+    return leaves;
+}
+
+#if ENABLE_BMI2
+// 查表翻转：逐个空格用 lineFlips 判断合法并翻转，子结点各复制一份位棋盘
+long long perftLine(struct player::BitBoard my, struct player::BitBoard opp, int depth, int passed) {
+    visited++;
+    if (depth == 0)
+        return 1;
+    struct player::BitBoard empty = player::bbAndNot(player::full_board, player::bbOr(my, opp));
+    long long leaves = 0;
+    int moves = 0;
+    while (!player::bbEmpty(empty)) {
+        int sq = player::popLowest(&empty);
+        struct player::BitBoard flips = player::lineFlips(sq, my, opp);
+        if (player::bbEmpty(flips))
+            continue;
+        moves++;
+        struct player::BitBoard next = player::bbOr(my, flips);
+        player::bbSet(&next, sq);
+        leaves += perftLine(player::bbAndNot(opp, flips), next, depth - 1, 0);
+    }
+    if (moves == 0)
+        return passed ? 1 : perftLine(opp, my, depth - 1, 1);
+    return leaves;
+}
+#endif
+
+// 批量估值测试用的叶子局面，my 为走棋一方
+struct player::BitBoard leaf_my[BATCH_POSITIONS], leaf_opp[BATCH_POSITIONS];
+int leaf_cnt;
+int leaf_terms[3][BATCH_POSITIONS][4]; // 参照、标量、AVX2 算出的己方行动力、对方行动力、子数差、权值和之差
+
+// 收集第 depth 步的叶子局面，停一手同 perftLine
+void collectLeaves(struct player::BitBoard my, struct player::BitBoard opp, int depth, int passed) {
+    if (leaf_cnt == BATCH_POSITIONS)
+        return;
+    if (depth == 0) {
+        leaf_my[leaf_cnt] = my;
+        leaf_opp[leaf_cnt] = opp;
+        leaf_cnt++;
+        return;
+    }
+    struct player::BitBoard moves = player::getMoves(my, opp);
+    if (player::bbEmpty(moves)) {
+        if (passed) {
+            leaf_my[leaf_cnt] = my;
+            leaf_opp[leaf_cnt] = opp;
+            leaf_cnt++;
+        } else {
+            collectLeaves(opp, my, depth - 1, 1);
+        }
+        return;
+    }
+    while (!player::bbEmpty(moves)) {
+        int sq = player::popLowest(&moves);
+        struct player::BitBoard flips = player::getFlips(sq, my, opp);
+        struct player::BitBoard next = player::bbOr(my, flips);
+        player::bbSet(&next, sq);
+        collectLeaves(player::bbAndNot(opp, flips), next, depth - 1, 0);
+    }
+}
+
+// 参照：逐个局面用运行期几何的 getMoves 和 getBoardWeight
+void leafReference(int out[][4]) {
+    for (int i = 0; i < leaf_cnt; i++) {
+        out[i][0] = player::bbCount(player::getMoves(leaf_my[i], leaf_opp[i]));
+        out[i][1] = player::bbCount(player::getMoves(leaf_opp[i], leaf_my[i]));
+        out[i][2] = player::bbCount(leaf_my[i]) - player::bbCount(leaf_opp[i]);
+        out[i][3] = player::getBoardWeight(leaf_my[i]) - player::getBoardWeight(leaf_opp[i]);
+    }
+}
+
+// 每 EVAL_BATCH 个局面一组送进 evaluateBatch
+template <int N>
+void leafBatch(int out[][4]) {
+    struct player::EvalBatch batch;
+    for (int base = 0; base < leaf_cnt; base += EVAL_BATCH) {
+        batch.n = 0;
+        for (int i = base; i < leaf_cnt && i < base + EVAL_BATCH; i++)
+            player::batchAdd(&batch, leaf_my[i], leaf_opp[i]);
+        player::evaluateBatch<N>(&batch);
+        for (int i = 0; i < batch.n; i++) {
+            out[base + i][0] = batch.moves[i];
+            out[base + i][1] = batch.opp_moves[i];
+            out[base + i][2] = batch.count[i];
+            out[base + i][3] = batch.weight[i];
+        }
+    }
+}
+
+void leafBatchSpecialized(int out[][4]) {
+    int side_len = row_cnt == col_cnt ? col_cnt : 0;
+    if (side_len == 8)
+        leafBatch<8>(out);
+    else if (side_len == 10)
+        leafBatch<10>(out);
+    else if (side_len == 12)
+        leafBatch<12>(out);
+    else
+        leafBatch<0>(out);
+}
+
+// 按棋盘大小选特化版本，同 player.h 的 init
+long long perftSpecialized(struct player::SearchContext *ctx, int depth) {
+    int side_len = row_cnt == col_cnt ? col_cnt : 0;
+    if (side_len == 8)
+        return perftBitboard<8>(ctx, depth, 0);
+    if (side_len == 10)
+        return perftBitboard<10>(ctx, depth, 0);
+    if (side_len == 12)
+        return perftBitboard<12>(ctx, depth, 0);
+    return perftBitboard<0>(ctx, depth, 0);
+}
+
+int main(int argc, char **argv) {
+    int max_depth = 6;
+    int opt;
+    while ((opt = getopt(argc, argv, "D:")) != -1) {
+        if (opt == 'D') {
+            max_depth = atoi(optarg);
+        } else {
+            fprintf(stderr, "Usage: %s [-D depth] map.txt ...\n", argv[0]);
+            return 1;
+        }
+    }
+    if (optind == argc || max_depth < 1) {
+        fprintf(stderr, "Usage: %s [-D depth] map.txt ...\n", argv[0]);
+        return 1;
+    }
+    static const char *names[5] = { "char", "computer", "generic", "bitboard", "line" };
+    int failed = 0;
+    printf("%-16s %5s %14s %10s %14s %10s %14s %10s %14s %10s %14s %10s %14s\n", "map", "depth", "leaves", "char ms", "char n/s",
+           "comp ms", "comp n/s", "gen ms", "gen n/s", "bb ms", "bb n/s", "line ms", "line n/s");
+    for (int m = optind; m < argc; m++) {
+        FILE *fp = fopen(argv[m], "r");
+        if (!fp || fscanf(fp, "%d%d", &row_cnt, &col_cnt) != 2 || row_cnt > 13 || col_cnt > 13) {
+            fprintf(stderr, "failed to load %s\n", argv[m]);
+            return 1;
+        }
+        char start[13][BOARD_COLS];
+        memset(start, 0, sizeof(start));
+        struct Player p;
+        p.row_cnt = row_cnt;
+        p.col_cnt = col_cnt;
+        p.your_score = p.opponent_score = 0;
+        p.mat = (char **)malloc(sizeof(char *) * row_cnt);
+        for (int i = 0; i < row_cnt; i++) {
+            p.mat[i] = start[i];
+            if (fscanf(fp, "%29s", start[i]) != 1) {
+                fprintf(stderr, "failed to load %s\n", argv[m]);
+                return 1;
+            }
+        }
+        fclose(fp);
+        player::init(&p);
+        struct player::SearchContext *ctx = &player::contexts[0];
+        player::readBoard(&p, &ctx->discs[0], &ctx->discs[1]);
+        ctx->side = 0;
+        ctx->undo_top = 0;
+        ctx->hash_key = player::computeHash(ctx);
+        player::initTerms(ctx);
+        for (int depth = 1; depth <= max_depth; depth++) {
+            long long leaves[5];
+            double ms[5], rate[5];
+            for (int g = 0; g < 5; g++) {
+                visited = 0;
+                double begin = nowMs();
+                if (g < 2) {
+                    char b[13][BOARD_COLS];
+                    memcpy(b, start, sizeof(b));
+                    leaves[g] = perftChar(b, 'O', 'o', depth, 0, g == 1);
+                } else if (g == 2) {
+                    bool has_bmi2 = player::bmi2_enabled;
+                    player::bmi2_enabled = false;
+                    leaves[g] = perftBitboard<0>(ctx, depth, 0);
+                    player::bmi2_enabled = has_bmi2;
+                } else if (g == 3) {
+                    leaves[g] = perftSpecialized(ctx, depth);
+                } else {
+#if ENABLE_BMI2
+                    if (player::bmi2_enabled)
+                        leaves[g] = perftLine(ctx->discs[0], ctx->discs[1], depth, 0);
+                    else
+#endif
+                        leaves[g] = leaves[0];
+                }
+                ms[g] = nowMs() - begin;
+                rate[g] = ms[g] > 0 ? visited / ms[g] * 1000 : 0.0;
+            }
+            printf("%-16s %5d %14lld %10.1f %14.0f %10.1f %14.0f %10.1f %14.0f %10.1f %14.0f %10.1f %14.0f\n", argv[m], depth, leaves[0],
+                   ms[0], rate[0], ms[1], rate[1], ms[2], rate[2], ms[3], rate[3], ms[4], rate[4]);
+            for (int g = 1; g < 5; g++)
+                if (leaves[g] != leaves[0]) {
+                    printf("  mismatch: %s counts %lld, char counts %lld\n", names[g], leaves[g], leaves[0]);
+                    failed = 1;
+                }
+        }
+        // 批量估值：参照、标量、AVX2，不支持 AVX2 时只比较前两种
+        leaf_cnt = 0;
+        collectLeaves(ctx->discs[0], ctx->discs[1], max_depth, 0);
+        bool has_avx2 = player::avx2_enabled;
+        double batch_ms[3] = { 0, 0, 0 };
+        for (int g = 0; g < 3; g++) {
+            if (g == 2 && !has_avx2)
+                break;
+            player::avx2_enabled = g == 2;
+            double begin = nowMs();
+            if (g == 0)
+                leafReference(leaf_terms[g]);
+            else
+                leafBatchSpecialized(leaf_terms[g]);
+            batch_ms[g] = nowMs() - begin;
+            if (g > 0 && memcmp(leaf_terms[g], leaf_terms[0], sizeof(leaf_terms[0][0]) * leaf_cnt) != 0) {
+                printf("  mismatch: evaluateBatch (%s) differs from per-position evaluation\n", g == 1 ? "scalar" : "avx2");
+                failed = 1;
+            }
+        }
+        player::avx2_enabled = has_avx2;
+        printf("  batch eval: %d positions, ref %.1f ms %.0f pos/s, scalar %.1f ms %.0f pos/s, avx2 ", leaf_cnt, batch_ms[0],
+               batch_ms[0] > 0 ? leaf_cnt / batch_ms[0] * 1000 : 0.0, batch_ms[1], batch_ms[1] > 0 ? leaf_cnt / batch_ms[1] * 1000 : 0.0);
+        if (has_avx2)
+            printf("%.1f ms %.0f pos/s\n", batch_ms[2], batch_ms[2] > 0 ? leaf_cnt / batch_ms[2] * 1000 : 0.0);
+        else
+            printf("unsupported\n");
+        free(p.mat);
+    }
+    return failed;
+}
@@ -0,0 +1,185 @@
+/**
+ * @file probcut_player.c
+ * @brief 离线拟合 Multi-ProbCut 参数：用 code/player.h 在随机分值的地图上自对弈，写出 data/probcut<边长>.bin
+ *
+ * 用法: ./bin/probcut_player [-s 边长] [-g 对局数] [-d 深度] [-r 随机步数] [-o 输出文件]
+ * 每局随机生成分值为 1~9 的方形地图，开局四子的摆法同 data/map*.txt。每一步都按固定深度 -d（默认 8）
+ * 迭代加深，记下各轮的根结点分值；前 -r 步（默认 8）随机落子，之后照搜索结果落子。
+ * 对每一段、每个深度 d，用浅层深度 probcutShallow(d) 的分值线性回归深度 d 的分值，
+ * 打印并写出斜率、截距和残差的标准差。估值和对局时一样（有模式表就用模式表），不用开局库，不做 ProbCut
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../code/player.h"
+#include "tool_util.h"
+
+#define MIN_SAMPLES 50 // 样本少于它的深度不给参数
+
+// 一个局面各轮迭代的根结点分值
+struct Sample {
+    int stage;
+    int score[PROBCUT_MAX_DEPTH + 1];
+};
+
+struct Sample *samples;
+long long sample_cnt, sample_cap;
+unsigned seed = 20210701;
+
+// 下一局，每个搜满 fixed_depth 轮的局面记进 samples
+void playGame(int size, int random_plies) {
+    struct Player player;
+    randomMap(&player, size, &seed);
+    init(&player);
+    int passes = 0;
+    for (int ply = 0; passes < 2; ply++) {
+        struct BitBoard my, opp;
+        readBoard(&player, &my, &opp);
+        struct BitBoard moves = getMoves(my, opp);
+        if (bbEmpty(moves)) {
+            passes++;
+            swapSide(&player);
+            continue;
+        }
+        passes = 0;
+        struct Point p = place(&player);
+        int discs = countDiscs(bbOr(my, opp));
+        if (!book_hit && exact_empties == 0 && last_depth == fixed_depth) {
+            if (sample_cnt == sample_cap) {
+                sample_cap = sample_cap ? sample_cap * 2 : 1 << 12;
+                samples = (struct Sample *)realloc(samples, sizeof(struct Sample) * sample_cap);
+            }
+            struct Sample *s = &samples[sample_cnt++];
+            s->stage = probcut_stage[discs];
+            memcpy(s->score, depth_score, sizeof(s->score));
+        }
+        if (ply < random_plies) {
+            int n = bbCount(moves), k = rand_r(&seed) % n;
+            int sq = popLowest(&moves);
+            while (k-- > 0)
+                sq = popLowest(&moves);
+            p = initPoint(sq / size, sq % size);
+        }
+        playMove(&player, p);
+        swapSide(&player);
+    }
+    freeMap(&player);
+}
+
+int main(int argc, char **argv) {
+    int size = 8, games = 200, random_plies = 8;
+    char out[256] = "";
+    fixed_depth = 8;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:g:d:r:o:")) != -1) {
+        if (opt == 's') {
+            size = atoi(optarg);
+        } else if (opt == 'g') {
+            games = atoi(optarg);
+        } else if (opt == 'd') {
+            fixed_depth = atoi(optarg);
+        } else if (opt == 'r') {
+            random_plies = atoi(optarg);
+        } else if (opt == 'o') {
+            snprintf(out, sizeof(out), "%s", optarg);
+        } else {
+            fprintf(stderr, "Usage: %s [-s size] [-g games] [-d depth] [-r random plies] [-o probcut.bin]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (size < 4 || size > 12 || size % 2 || games < 1 || fixed_depth < PROBCUT_MIN_DEPTH || fixed_depth > PROBCUT_MAX_DEPTH) {
+        fprintf(stderr, "Usage: %s [-s size] [-g games] [-d depth] [-r random plies] [-o probcut.bin]\n", argv[0]);
+        return 1;
+    }
+    if (!out[0])
+        snprintf(out, sizeof(out), PROBCUT_FILE, size);
+    // 拟合时不做 ProbCut，不用开局库，不做后台思考，也不写搜索记录
+    probcut_path = NULL;
+    book_path = NULL;
+    ponder_enabled = false;
+    telemetry_path = NULL;
+    search_threads = 1;
+    double start = nowMs();
+    int uses_pattern = 0;
+    for (int g = 0; g < games; g++) {
+        playGame(size, random_plies);
+        uses_pattern = pattern_table != NULL;
+        if ((g + 1) % 10 == 0) {
+            printf("games %d, positions %lld, %.0f ms\n", g + 1, sample_cnt, nowMs() - start);
+            fflush(stdout);
+        }
+    }
+    // 按段、按深度做一元线性回归：深度 d 的分值 = a * 浅层分值 + b
+    struct ProbCut fit[PROBCUT_STAGES][PROBCUT_MAX_DEPTH + 1];
+    memset(fit, 0, sizeof(fit));
+    printf("%6s %6s %8s %8s %8s %10s %10s\n", "stage", "depth", "shallow", "samples", "a", "b", "sigma");
+    for (int stage = 0; stage < PROBCUT_STAGES; stage++)
+        for (int d = PROBCUT_MIN_DEPTH; d <= fixed_depth; d++) {
+            int shallow = probcutShallow(d);
+            double sx = 0, sy = 0, sxx = 0, sxy = 0;
+            long long n = 0;
+            for (long long k = 0; k < sample_cnt; k++) {
+                const struct Sample *s = &samples[k];
+                int x = s->score[shallow], y = s->score[d];
+                if (s->stage != stage || abs(x) >= WIN_SCORE / 2 || abs(y) >= WIN_SCORE / 2)
+                    continue;
+                sx += x;
+                sy += y;
+                sxx += (double)x * x;
+                sxy += (double)x * y;
+                n++;
+            }
+            if (n < MIN_SAMPLES || sxx * n - sx * sx <= 0) {
+                printf("%6d %6d %8d %8lld %8s %10s %10s\n", stage, d, shallow, n, "-", "-", "-");
+                continue;
+            }
+            double a = (sxy * n - sx * sy) / (sxx * n - sx * sx);
+            double b = (sy - a * sx) / n;
+            double sse = 0;
+            for (long long k = 0; k < sample_cnt; k++) {
+                const struct Sample *s = &samples[k];
+                int x = s->score[shallow], y = s->score[d];
+                if (s->stage != stage || abs(x) >= WIN_SCORE / 2 || abs(y) >= WIN_SCORE / 2)
+                    continue;
+                double e = y - (a * x + b);
+                sse += e * e;
+            }
+            double sigma = sqrt(sse / (n > 2 ? n - 2 : 1));
+            printf("%6d %6d %8d %8lld %8.3f %10.2f %10.2f\n", stage, d, shallow, n, a, b, sigma);
+            // 斜率太小时浅层搜索说明不了什么，这一层不剪
+            if (a > 0.1) {
+                fit[stage][d].a = (float)a;
+                fit[stage][d].b = (float)b;
+                fit[stage][d].sigma = (float)sigma;
+            }
+        }
+    FILE *fp = fopen(out, "wb");
+    if (!fp) {
+        perror(out);
+        return 1;
+    }
+    struct ProbCutHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = PROBCUT_MAGIC;
+    header.version = PROBCUT_VERSION;
+    header.size = size;
+    header.stages = PROBCUT_STAGES;
+    header.depths = fixed_depth;
+    header.pattern = uses_pattern;
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+    for (int stage = 0; stage < PROBCUT_STAGES && ok; stage++)
+        ok = fwrite(fit[stage], sizeof(struct ProbCut), fixed_depth + 1, fp) == (size_t)fixed_depth + 1;
+    fclose(fp);
+    if (!ok) {
+        perror(out);
+        return 1;
+    }
+    printf("wrote %lld positions fitted to %s, %s evaluation\n", sample_cnt, out, uses_pattern ? "pattern" : "hand-written");
+    free(samples);
+    return 0;
+}
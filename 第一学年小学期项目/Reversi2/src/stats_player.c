@@ -0,0 +1,158 @@
+/**
+ * @file stats_player.c
+ * @brief 汇总 code/player.h 写下的搜索记录（log/telemetry.bin），按棋盘大小和对局阶段统计
+ *
+ * 用法: ./bin/stats_player [-v] [log/telemetry.bin ...]
+ * 不给文件时读 log/telemetry.bin；多个文件的记录合在一起统计，对局按记录里的对局编号区分。
+ * 每种棋盘大小一行总计：对局数、步数、开局库步数、精确求解步数、到限时被中止的步数、平均深度、
+ * 结点/秒、第一个子结点就剪掉的比例、置换表命中率、平均和最长用时；再按棋子数把一局分成四段列出深度和用时
+ * -v 逐步打印每条记录和主要变例
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../code/player.h"
+
+#define MAX_SIZES 16  // 不同棋盘大小的种数上限
+#define MAX_GAMES 65536 // 统计对局数时记下的对局编号个数上限
+#define PHASES 4      // 按棋子数把一局分成的段数
+
+// 一类记录的累计值
+struct Stats {
+    long long moves, book, exact, timeout;
+    long long depth_sum, nodes, tt_probes, tt_hits, cutoffs, first_cutoffs;
+    double ms, max_ms;
+};
+
+struct SizeStats {
+    int rows, cols;
+    int games;
+    struct Stats total;
+    struct Stats phase[PHASES];
+};
+
+struct SizeStats sizes[MAX_SIZES];
+int size_cnt;
+uint64_t games[MAX_GAMES];
+int game_cnt;
+int verbose;
+
+void addRecord(struct Stats *st, const struct TelemetryRecord *rec) {
+    st->moves++;
+    st->book += (rec->flags & TELEMETRY_BOOK) != 0;
+    st->exact += (rec->flags & TELEMETRY_EXACT) != 0;
+    st->timeout += (rec->flags & TELEMETRY_TIMEOUT) != 0;
+    st->depth_sum += rec->depth;
+    st->nodes += rec->nodes;
+    st->tt_probes += rec->tt_probes;
+    st->tt_hits += rec->tt_hits;
+    st->cutoffs += rec->cutoffs;
+    st->first_cutoffs += rec->first_cutoffs;
+    st->ms += rec->ms;
+    if (rec->ms > st->max_ms)
+        st->max_ms = rec->ms;
+}
+
+// 新的对局编号返回 1
+int newGame(uint64_t game) {
+    for (int i = 0; i < game_cnt; i++)
+        if (games[i] == game)
+            return 0;
+    if (game_cnt < MAX_GAMES)
+        games[game_cnt++] = game;
+    return 1;
+}
+
+struct SizeStats *findSize(int rows, int cols) {
+    for (int i = 0; i < size_cnt; i++)
+        if (sizes[i].rows == rows && sizes[i].cols == cols)
+            return &sizes[i];
+    if (size_cnt == MAX_SIZES)
+        return NULL;
+    struct SizeStats *s = &sizes[size_cnt++];
+    memset(s, 0, sizeof(*s));
+    s->rows = rows;
+    s->cols = cols;
+    return s;
+}
+
+void printRecord(const struct TelemetryRecord *rec) {
+    printf("%016llx %4d %3dx%-3d %7d %5d %10llu %8.1f %6.1f%% %6.1f%% %9d %c%c%c%c%c ", (unsigned long long)rec->game, rec->ply, rec->rows, rec->cols,
+           rec->empties, rec->depth, (unsigned long long)rec->nodes, rec->ms, rec->cutoffs ? 100.0 * rec->first_cutoffs / rec->cutoffs : 0.0,
+           rec->tt_probes ? 100.0 * rec->tt_hits / rec->tt_probes : 0.0, rec->score, rec->flags & TELEMETRY_BOOK ? 'b' : '-',
+           rec->flags & TELEMETRY_EXACT ? 'x' : '-', rec->flags & TELEMETRY_MCTS ? 'm' : '-', rec->flags & TELEMETRY_PONDER_HIT ? 'p' : '-',
+           rec->flags & TELEMETRY_TIMEOUT ? 't' : '-');
+    for (int i = 0; i < rec->pv_len && i < TELEMETRY_PV; i++)
+        printf(" %c%d", 'a' + rec->pv[i] % rec->cols, rec->pv[i] / rec->cols + 1);
+    printf("\n");
+}
+
+int loadLog(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        perror(path);
+        return 1;
+    }
+    struct TelemetryRecord rec;
+    while (fread(&rec, sizeof(rec), 1, fp) == 1) {
+        if (rec.version != TELEMETRY_VERSION || rec.cols == 0)
+            continue;
+        struct SizeStats *s = findSize(rec.rows, rec.cols);
+        if (!s)
+            continue;
+        s->games += newGame(rec.game);
+        addRecord(&s->total, &rec);
+        int cells = rec.rows * rec.cols;
+        int phase = (cells - rec.empties) * PHASES / (cells + 1);
+        addRecord(&s->phase[phase], &rec);
+        if (verbose)
+            printRecord(&rec);
+    }
+    fclose(fp);
+    return 0;
+}
+
+void printStats(const char *name, int games, const struct Stats *st) {
+    printf("%-10s %6d %7lld %6lld %6lld %7lld %6.2f %12.0f %8.1f%% %7.1f%% %8.2f %8.1f\n", name, games, st->moves, st->book, st->exact, st->timeout,
+           st->moves ? (double)st->depth_sum / st->moves : 0.0, st->ms > 0 ? st->nodes / st->ms * 1000 : 0.0,
+           st->cutoffs ? 100.0 * st->first_cutoffs / st->cutoffs : 0.0, st->tt_probes ? 100.0 * st->tt_hits / st->tt_probes : 0.0,
+           st->moves ? st->ms / st->moves : 0.0, st->max_ms);
+}
+
+int main(int argc, char **argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "v")) != -1) {
+        if (opt == 'v') {
+            verbose = 1;
+        } else {
+            fprintf(stderr, "Usage: %s [-v] [telemetry.bin ...]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (verbose)
+        printf("%-16s %4s %7s %7s %5s %10s %8s %7s %7s %9s %5s  %s\n", "game", "ply", "size", "empties", "depth", "nodes", "ms", "first", "tt hit", "score", "flags", "pv");
+    if (optind == argc) {
+        if (loadLog(TELEMETRY_FILE))
+            return 1;
+    }
+    for (int i = optind; i < argc; i++)
+        if (loadLog(argv[i]))
+            return 1;
+    printf("%-10s %6s %7s %6s %6s %7s %6s %12s %9s %8s %8s %8s\n", "size", "games", "moves", "book", "exact", "timeout", "depth", "nodes/s", "first cut", "tt hit",
+           "avg ms", "max ms");
+    for (int i = 0; i < size_cnt; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "%dx%d", sizes[i].rows, sizes[i].cols);
+        printStats(name, sizes[i].games, &sizes[i].total);
+        for (int p = 0; p < PHASES; p++) {
+            if (sizes[i].phase[p].moves == 0)
+                continue;
+            snprintf(name, sizeof(name), "  %d/%d", p + 1, PHASES);
+            printStats(name, 0, &sizes[i].phase[p]);
+        }
+    }
+    return 0;
+}
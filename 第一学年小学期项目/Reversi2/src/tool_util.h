@@ -0,0 +1,98 @@
+/**
+ * @file tool_util.h
+ * @brief 本地工具共用的地图和计时函数：读地图、生成随机地图、交换视角、按裁判规则落子
+ *
+ * bench_player、book_player、train_player、probcut_player 都直接驱动 code/player.h 自对弈，
+ * 在 Player 的字符棋盘上走棋，和裁判看到的一样
+ */
+
+#ifndef SRC_TOOL_UTIL_H_
+#define SRC_TOOL_UTIL_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../include/playerbase.h"
+
+// 读入地图文件：第一行为行数和列数，之后每行一个字符串
+int loadMap(struct Player *player, const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        perror(path);
+        return 1;
+    }
+    if (fscanf(fp, "%d%d", &player->row_cnt, &player->col_cnt) != 2) {
+        fclose(fp);
+        return 1;
+    }
+    player->mat = (char **)malloc(sizeof(char *) * player->row_cnt);
+    for (int i = 0; i < player->row_cnt; i++) {
+        player->mat[i] = (char *)malloc(player->col_cnt + 2);
+        if (fscanf(fp, "%s", player->mat[i]) != 1) {
+            fclose(fp);
+            return 1;
+        }
+    }
+    player->your_score = player->opponent_score = 0;
+    fclose(fp);
+    return 0;
+}
+
+// 生成边长为 n 的随机地图：格子分值为 1~9，开局四子的摆法同 data/map*.txt
+void randomMap(struct Player *player, int n, unsigned *seed) {
+    player->row_cnt = player->col_cnt = n;
+    player->mat = (char **)malloc(sizeof(char *) * n);
+    for (int i = 0; i < n; i++) {
+        player->mat[i] = (char *)calloc(n + 2, 1);
+        for (int j = 0; j < n; j++)
+            player->mat[i][j] = '1' + rand_r(seed) % 9;
+    }
+    player->mat[n / 2 - 1][n / 2 - 1] = player->mat[n / 2][n / 2] = 'o';
+    player->mat[n / 2 - 1][n / 2] = player->mat[n / 2][n / 2 - 1] = 'O';
+    player->your_score = player->opponent_score = 0;
+}
+
+void freeMap(struct Player *player) {
+    for (int i = 0; i < player->row_cnt; i++)
+        free(player->mat[i]);
+    free(player->mat);
+    player->mat = NULL;
+}
+
+// 交换视角：下一手的一方总是看到自己的棋子为 'O'
+void swapSide(struct Player *player) {
+    for (int i = 0; i < player->row_cnt; i++)
+        for (int j = 0; j < player->col_cnt; j++) {
+            if (player->mat[i][j] == 'O')
+                player->mat[i][j] = 'o';
+            else if (player->mat[i][j] == 'o')
+                player->mat[i][j] = 'O';
+        }
+}
+
+// 按裁判规则在 mat 上落子：沿八个方向夹住的 'o' 翻成 'O'，遇到空格（数字）或边界停止
+void playMove(struct Player *player, struct Point p) {
+    static const int dx[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+    static const int dy[8] = { 1, -1, 0, 0, 1, -1, -1, 1 };
+    player->mat[p.X][p.Y] = 'O';
+    for (int d = 0; d < 8; d++) {
+        int x = p.X + dx[d], y = p.Y + dy[d];
+        while (x >= 0 && x < player->row_cnt && y >= 0 && y < player->col_cnt && player->mat[x][y] == 'o') {
+            x += dx[d];
+            y += dy[d];
+        }
+        if (x < 0 || x >= player->row_cnt || y < 0 || y >= player->col_cnt || player->mat[x][y] != 'O')
+            continue;
+        for (x -= dx[d], y -= dy[d]; x != p.X || y != p.Y; x -= dx[d], y -= dy[d])
+            player->mat[x][y] = 'O';
+    }
+}
+
+double nowMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+#endif  // SRC_TOOL_UTIL_H_
@@ -0,0 +1,227 @@
+/**
+ * @file train_player.c
+ * @brief 离线拟合模式估值表：用 code/player.h 在随机分值的地图上自对弈，按终局得分差拟合，写出 data/pattern<边长>.bin
+ *
+ * 用法: ./bin/train_player [-s 边长] [-g 对局数] [-d 深度] [-r 随机步数] [-i 轮数] [-o 输出文件]
+ * 每局随机生成分值为 1~9 的方形地图，开局四子的摆法同 data/map*.txt；先随机走 -r 步（默认 8），
+ * 之后双方用手写的估值按固定深度 -d（默认 4）搜索，空格数不超过终局门槛时精确求解。
+ * 每个局面按走棋一方记下各模式的索引和格子分值差，以走棋一方的最终得分差为目标，
+ * 用梯度下降拟合 -i 轮（默认 60），留出十分之一的局面检验，每轮打印两边的均方根误差
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../code/player.h"
+#include "tool_util.h"
+
+#define HOLDOUT 10      // 每 10 局留 1 局检验
+#define RARE_COUNT 20   // 出现次数少的表项按 count / (count + 20) 缩小步长
+
+// 一个局面：走棋一方为 discs[0]
+struct Sample {
+    uint16_t index[PATTERN_INSTANCES];
+    int16_t value_diff; // 格子分值差
+    int16_t target;     // 最终得分差
+    uint8_t stage;
+    uint8_t holdout;
+};
+
+struct Sample *samples;
+long long sample_cnt, sample_cap;
+unsigned seed = 20210701;
+
+// 当前局面的估值统计，走棋一方为 discs[0]
+struct EvalTerms readTerms(struct Player *player) {
+    struct SearchContext *ctx = &contexts[0];
+    readBoard(player, &ctx->discs[0], &ctx->discs[1]);
+    initTerms(ctx);
+    return ctx->terms;
+}
+
+// 下一局，局面记进 samples，目标值在终局后补上
+void playGame(int size, int holdout, int random_plies) {
+    struct Player player;
+    randomMap(&player, size, &seed);
+    init(&player);
+    long long first = sample_cnt;
+    int turn = 0, passes = 0; // turn 为当前 'O' 一方是否为后手
+    for (int ply = 0; passes < 2; ply++) {
+        struct BitBoard my, opp;
+        readBoard(&player, &my, &opp);
+        struct BitBoard moves = getMoves(my, opp);
+        if (bbEmpty(moves)) {
+            passes++;
+            swapSide(&player);
+            turn ^= 1;
+            continue;
+        }
+        passes = 0;
+        if (sample_cnt == sample_cap) {
+            sample_cap = sample_cap ? sample_cap * 2 : 1 << 16;
+            samples = (struct Sample *)realloc(samples, sizeof(struct Sample) * sample_cap);
+        }
+        struct Sample *s = &samples[sample_cnt++];
+        struct EvalTerms terms = readTerms(&player);
+        memcpy(s->index, terms.index, sizeof(s->index));
+        s->value_diff = terms.value[0] - terms.value[1];
+        s->stage = pattern_stage[terms.count[0] + terms.count[1]];
+        s->holdout = holdout;
+        s->target = turn; // 先记下是哪一方，终局后换成得分差
+        struct Point p;
+        if (ply < random_plies) {
+            int n = bbCount(moves), k = rand_r(&seed) % n;
+            int sq = popLowest(&moves);
+            while (k-- > 0)
+                sq = popLowest(&moves);
+            p = initPoint(sq / size, sq % size);
+        } else {
+            p = place(&player);
+        }
+        playMove(&player, p);
+        swapSide(&player);
+        turn ^= 1;
+    }
+    struct EvalTerms terms = readTerms(&player);
+    int diff = terms.value[0] - terms.value[1];
+    for (long long i = first; i < sample_cnt; i++)
+        samples[i].target = samples[i].target == turn ? diff : -diff;
+    freeMap(&player);
+}
+
+// 一个局面的预测值
+double predict(const struct Sample *s, const double *w, const double *a) {
+    const double *table = w + (size_t)s->stage * pattern_size;
+    double pred = a[s->stage] * s->value_diff;
+    for (int i = 0; i < pattern_cnt; i++)
+        pred += table[pattern_base[i] + s->index[i]];
+    return pred;
+}
+
+int main(int argc, char **argv) {
+    int size = 8, games = 10000, random_plies = 8, rounds = 60;
+    char out[256] = "";
+    fixed_depth = 4;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:g:d:r:i:o:")) != -1) {
+        if (opt == 's') {
+            size = atoi(optarg);
+        } else if (opt == 'g') {
+            games = atoi(optarg);
+        } else if (opt == 'd') {
+            fixed_depth = atoi(optarg);
+        } else if (opt == 'r') {
+            random_plies = atoi(optarg);
+        } else if (opt == 'i') {
+            rounds = atoi(optarg);
+        } else if (opt == 'o') {
+            snprintf(out, sizeof(out), "%s", optarg);
+        } else {
+            fprintf(stderr, "Usage: %s [-s size] [-g games] [-d depth] [-r random plies] [-i rounds] [-o pattern.bin]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (size < 8 || size > 12 || games < HOLDOUT) {
+        fprintf(stderr, "Usage: %s [-s size] [-g games] [-d depth] [-r random plies] [-i rounds] [-o pattern.bin]\n", argv[0]);
+        return 1;
+    }
+    if (!out[0])
+        snprintf(out, sizeof(out), PATTERN_FILE, size);
+    // 对局用手写的估值，不用开局库，不做后台思考，也不写搜索记录
+    pattern_path = NULL;
+    book_path = NULL;
+    telemetry_path = NULL;
+    ponder_enabled = false;
+    search_threads = 1;
+    double start = nowMs();
+    for (int g = 0; g < games; g++) {
+        playGame(size, g % HOLDOUT == 0, random_plies);
+        if ((g + 1) % 1000 == 0) {
+            printf("games %d, positions %lld, %.0f ms\n", g + 1, sample_cnt, nowMs() - start);
+            fflush(stdout);
+        }
+    }
+    // 梯度下降：每轮累计每个表项的残差，按出现次数取平均后整体挪一步；
+    // 一个局面同时落在 pattern_cnt 个表项上，步长取 1 / pattern_cnt 免得一起挪过头
+    size_t n = (size_t)PATTERN_STAGES * pattern_size;
+    double *w = (double *)calloc(n, sizeof(double));
+    double *grad = (double *)malloc(sizeof(double) * n);
+    int *count = (int *)malloc(sizeof(int) * n);
+    double a[PATTERN_STAGES], grad_a[PATTERN_STAGES], norm_a[PATTERN_STAGES];
+    for (int s = 0; s < PATTERN_STAGES; s++)
+        a[s] = 1.0;
+    double rate = 1.0 / pattern_cnt;
+    printf("%6s %10s %10s\n", "round", "train rms", "test rms");
+    for (int r = 1; r <= rounds; r++) {
+        memset(grad, 0, sizeof(double) * n);
+        memset(count, 0, sizeof(int) * n);
+        memset(grad_a, 0, sizeof(grad_a));
+        memset(norm_a, 0, sizeof(norm_a));
+        double sse[2] = { 0, 0 };
+        long long cnt[2] = { 0, 0 };
+        for (long long k = 0; k < sample_cnt; k++) {
+            const struct Sample *s = &samples[k];
+            double e = s->target - predict(s, w, a);
+            sse[s->holdout] += e * e;
+            cnt[s->holdout]++;
+            if (s->holdout)
+                continue;
+            size_t base = (size_t)s->stage * pattern_size;
+            for (int i = 0; i < pattern_cnt; i++) {
+                grad[base + pattern_base[i] + s->index[i]] += e;
+                count[base + pattern_base[i] + s->index[i]]++;
+            }
+            grad_a[s->stage] += e * s->value_diff;
+            norm_a[s->stage] += (double)s->value_diff * s->value_diff;
+        }
+        for (size_t i = 0; i < n; i++)
+            if (count[i] > 0)
+                w[i] += rate * grad[i] / (count[i] + RARE_COUNT);
+        for (int s = 0; s < PATTERN_STAGES; s++)
+            if (norm_a[s] > 0)
+                a[s] += 0.5 * grad_a[s] / norm_a[s];
+        printf("%6d %10.3f %10.3f\n", r, sqrt(sse[0] / (cnt[0] ? cnt[0] : 1)), sqrt(sse[1] / (cnt[1] ? cnt[1] : 1)));
+        fflush(stdout);
+    }
+    FILE *fp = fopen(out, "wb");
+    if (!fp) {
+        perror(out);
+        return 1;
+    }
+    struct PatternHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = PATTERN_MAGIC;
+    header.version = PATTERN_VERSION;
+    header.size = size;
+    header.stages = PATTERN_STAGES;
+    header.entries = pattern_size;
+    int16_t value_weight[PATTERN_STAGES];
+    for (int s = 0; s < PATTERN_STAGES; s++)
+        value_weight[s] = (int16_t)lround(a[s] * PATTERN_SCALE);
+    int16_t *table = (int16_t *)malloc(sizeof(int16_t) * n);
+    for (size_t i = 0; i < n; i++) {
+        long v = lround(w[i] * PATTERN_SCALE);
+        table[i] = (int16_t)(v > 32767 ? 32767 : v < -32767 ? -32767 : v);
+    }
+    if (fwrite(&header, sizeof(header), 1, fp) != 1 || fwrite(value_weight, sizeof(int16_t), PATTERN_STAGES, fp) != PATTERN_STAGES ||
+        fwrite(table, sizeof(int16_t), n, fp) != n) {
+        perror(out);
+        fclose(fp);
+        return 1;
+    }
+    fclose(fp);
+    printf("wrote %lld positions fitted to %s, value weight", sample_cnt, out);
+    for (int s = 0; s < PATTERN_STAGES; s++)
+        printf(" %.2f", a[s]);
+    printf("\n");
+    free(table);
+    free(w);
+    free(grad);
+    free(count);
+    free(samples);
+    return 0;
+}
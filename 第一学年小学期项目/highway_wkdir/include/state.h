@@ -6,9 +6,27 @@
 #define MAX 65536
 #define INF 0x3f3f3f3f
 
+// 点的编号方式
+#define ORDER_ROW 0     // 行优先（默认）
+#define ORDER_HILBERT 1 // 按块走 Hilbert 曲线，块内 Morton 序
+#define ORDER_TILE 8    // 块的边长（格）
+
+#define MAX_FRAME 64    // 时间片数量上限
+
+typedef struct EdgeNode
+{
+    int vertex; // 终点坐标
+    int next;
+} Edge;
+
 struct State
 {
     // data structure
+    int weight[MAX];     // 点的权值
+    Edge edge[MAX];      // 边数组
+    int head[MAX];       // 头结点
+    int edgeNum;         // 边的数量
+    int nodeNum;         // 点的数量
     int visited[MAX];
     int pathLength[MAX]; // 存路径长度
     int minPath[MAX];    // 存最短路路径
@@ -16,13 +34,41 @@ struct State
     int deletedEdge;     // 删去的边
     int row;
     int column;
+    int order;           // 点的编号方式
+    int source;          // 起点编号
+    int target;          // 终点编号
+    int cellRow[MAX];    // 点所在的行（从 0 开始）
+    int cellCol[MAX];    // 点在行内的位置（从 0 开始）
+    int cellNode[MAX];   // 行 * column + 列 -> 点的编号
+    int cellPixel[MAX];  // 点在图片中是第几个采样列（从 0 开始，留白格也计数），读帧时按它对齐格子
+    int sweeps;          // 上次 solveWave 的扫描轮数
+};
+
+// 按时间片变化的地图序列，每帧只保存按点编号排列的权值
+struct Frames
+{
+    const char *files[MAX_FRAME]; // 每个时间片对应的图片
+    int *weights[MAX_FRAME];      // 已解码的权值，未用到的帧为 NULL
+    int failed[MAX_FRAME];        // 解码失败的帧，记下后不再重试
+    int count;                    // 帧数
+    int slice;                    // 每帧持续的时长（与路径长度同单位）
+    int loaded;                   // 实际解码过的帧数
 };
 
 // function
 void init_State(struct State *s);
 void delete_State(struct State *s);
+void set_order(struct State *s, int order);
 void parse(struct State *s, struct PNG *p);
+int node_of(struct State *s, int row, int col);
+void cell_of(struct State *s, int node, int *row, int *col);
 int solve1(struct State *s);
 int solve2(struct State *s);
+int solveWave(struct State *s);
+
+void init_Frames(struct Frames *f, int slice);
+void delete_Frames(struct Frames *f);
+int add_Frame(struct Frames *f, const char *file_name);
+int solveTimed(struct State *s, struct Frames *f);
 
 #endif
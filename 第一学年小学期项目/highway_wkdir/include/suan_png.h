@@ -15,6 +15,7 @@ struct PNG
 void init_PNG(struct PNG *p);
 void delete_PNG(struct PNG *p);
 int load(struct PNG *p, const char *file_name);
+int load_rows(const char *file_name, void (*row_fn)(void *ctx, int y, struct PXL *row, int width, int height), void *ctx);
 int save(struct PNG *p, const char *file_name);
 struct PXL *get_PXL(struct PNG *p, int x, int y);
 int get_width(struct PNG *p);
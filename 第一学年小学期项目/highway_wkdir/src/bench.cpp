@@ -0,0 +1,119 @@
+#include "suan_png.h"
+#include "pxl.h"
+#include "state.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <chrono>
+
+int usage();
+
+void make_map(struct PNG *png, int rows, int cols, unsigned seed);
+
+void bench(const char *name, struct PNG *png, int order, int reps);
+
+int main(int argc, char **argv) {
+    int reps = 5;
+    int rows = 0, cols = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:g:h")) != -1) {
+        if (opt == 'n') {
+            reps = atoi(optarg);
+        } else if (opt == 'g') {
+            if (sscanf(optarg, "%dx%d", &rows, &cols) != 2 || rows < 2 || cols < 2) {
+                usage();
+            }
+        } else {
+            usage();
+        }
+    }
+    if (reps <= 0 || (optind == argc && rows == 0)) {
+        usage();
+    }
+
+    printf("%-24s %-8s %7s %10s %10s %12s %12s %7s\n", "map", "order", "nodes", "avg|u-v|", "same line", "solve1 ms", "wave ms", "sweeps");
+    for (int i = optind; i < argc; i++) {
+        struct PNG *png = new PNG();
+        init_PNG(png);
+        if (load(png, argv[i]) == 0) {
+            bench(argv[i], png, ORDER_ROW, reps);
+            bench(argv[i], png, ORDER_HILBERT, reps);
+        }
+        delete_PNG(png);
+        delete png;
+    }
+    if (rows > 0) {
+        char name[32];
+        snprintf(name, sizeof(name), "random %dx%d", rows, cols);
+        struct PNG *png = new PNG();
+        init_PNG(png);
+        make_map(png, rows, cols, 2024);
+        bench(name, png, ORDER_ROW, reps);
+        bench(name, png, ORDER_HILBERT, reps);
+        delete_PNG(png);
+        delete png;
+    }
+    return 0;
+}
+
+int usage() {
+    printf("Usage: ./bench [-n reps] [-g ROWSxCOLS] [map.png ...]\n"
+           "[-n]: 每种编号方式重复求解的次数，默认 5\n"
+           "[-g]: 另外生成一张 ROWS 行 COLS 列的随机地图\n");
+    exit(1);
+}
+
+// 按 pic/ 中地图的格式生成随机地图：每格 8 像素，只在采样点 (8c+6, 8r+6) 上色，
+// 偶数行（从 1 数）比奇数行少一格，最后一格留白
+void make_map(struct PNG *png, int rows, int cols, unsigned seed) {
+    png->width = cols * 8;
+    png->height = rows * 8;
+    png->image = new PXL[png->width * png->height];
+    for (int i = 0; i < png->width * png->height; i++) {
+        init_pxl1(&png->image[i]);
+    }
+    srand(seed);
+    for (int r = 0; r < rows; r++) {
+        int line = r % 2 == 0 ? cols : cols - 1;
+        for (int c = 0; c < line; c++) {
+            init_pxl2(get_PXL(png, c * 8 + 6, r * 8 + 6), rand() % 250, rand() % 250, rand() % 250, 255);
+        }
+    }
+}
+
+// 访存局部性用编号差衡量：|u-v| 越小，松弛时 pathLength/visited 的访问越集中；
+// same line 为两端落在同一条 64 字节缓存行（16 个 int）里的边所占比例
+void bench(const char *name, struct PNG *png, int order, int reps) {
+    State *state = new State();
+    double total = 0, same = 0, cost_ms = 0;
+    double wave_ms = 0;
+    int ans = 0, wave = 0;
+    for (int k = 0; k < reps; k++) {
+        init_State(state);
+        set_order(state, order);
+        parse(state, png);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        ans = solve1(state);
+        std::chrono::duration<double, std::milli> cost = std::chrono::steady_clock::now() - start;
+        cost_ms += cost.count();
+
+        start = std::chrono::steady_clock::now();
+        wave = solveWave(state);
+        cost = std::chrono::steady_clock::now() - start;
+        wave_ms += cost.count();
+    }
+    for (int u = 1; u <= state->nodeNum; u++) {
+        for (int i = state->head[u]; i != 0; i = state->edge[i].next) {
+            int v = state->edge[i].vertex;
+            total += u > v ? u - v : v - u;
+            same += u / 16 == v / 16;
+        }
+    }
+    printf("%-24s %-8s %7d %10.1f %9.1f%% %12.3f %12.3f %7d   (%d%s)\n", name, order == ORDER_ROW ? "row" : "hilbert",
+           state->nodeNum, total / state->edgeNum, 100.0 * same / state->edgeNum, cost_ms / reps, wave_ms / reps,
+           state->sweeps, ans, ans == wave ? "" : " wave mismatch");
+    delete_State(state);
+    delete state;
+}
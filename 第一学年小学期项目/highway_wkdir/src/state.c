@@ -1,38 +1,37 @@
 #include "state.h"
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define WAVE_AVX2 1
+#endif
 
-typedef struct Point
-{
-    int weight; // 点的权值
-} PointWeight;  // 州的点集合
-
-PointWeight Point[MAX];
-int path[MAX];
-
-typedef struct EdgeNode
-{
-    int vertex; // 终点坐标
-    int next;
-} Edge;
-
-Edge edge[MAX];  // 边数组
-int head[MAX];   // 头结点
-int edgeNum = 0; // 边的数量
-int nodeNum = 0;
+// 图的全部数据都放在 State 里，多个 State 可以在不同线程中同时求解
 
 void init_State(struct State *s)
 {
-    for (int i = 0; i <= MAX; i++)
+    for (int i = 0; i < MAX; i++)
     {
         s->pathLength[i] = INF;
         s->visited[i] = 0;
         s->minPath[i] = 0;
-        s->secondMinPath = INF;
+        s->head[i] = 0;
     }
+    s->secondMinPath = INF;
+    s->edgeNum = 0, s->nodeNum = 0;
     s->row = 0, s->column = 0; // 初始化
+    s->order = ORDER_ROW;
+    s->source = 1, s->target = 0;
+    s->sweeps = 0;
     return;
 }
 
+void set_order(struct State *s, int order)
+{
+    s->order = order;
+}
+
 void delete_State(struct State *s)
 {
     // TODO
@@ -43,23 +42,26 @@ int max(int x, int y)
     return x > y ? x : y;
 }
 
-void insertEdge(int u, int v)
+void insertEdge(struct State *s, int u, int v)
 {
-    edge[++edgeNum].vertex = v;
-    edge[edgeNum].next = head[u];
-    head[u] = edgeNum;
+    s->edge[++s->edgeNum].vertex = v;
+    s->edge[s->edgeNum].next = s->head[u];
+    s->head[u] = s->edgeNum;
 }
 
 void buildEdge(struct State *s, int weight, int column)
 {
     int maxLine = s->column;
-    Point[++nodeNum].weight = weight;
+    int nodeNum = ++s->nodeNum;
+    s->weight[nodeNum] = weight;
+    s->cellRow[nodeNum] = s->row - 1;
+    s->cellCol[nodeNum] = column - 1;
     if (s->row % 2 == 0)
     {
-        insertEdge(nodeNum, nodeNum - maxLine);
-        insertEdge(nodeNum - maxLine, nodeNum);
-        insertEdge(nodeNum, nodeNum - maxLine + 1);
-        insertEdge(nodeNum - maxLine + 1, nodeNum);
+        insertEdge(s, nodeNum, nodeNum - maxLine);
+        insertEdge(s, nodeNum - maxLine, nodeNum);
+        insertEdge(s, nodeNum, nodeNum - maxLine + 1);
+        insertEdge(s, nodeNum - maxLine + 1, nodeNum);
     }
     if (s->row % 2 == 1)
     {
@@ -67,20 +69,20 @@ void buildEdge(struct State *s, int weight, int column)
         {
             if (column < maxLine)
             {
-                insertEdge(nodeNum, nodeNum - (maxLine - 1));
-                insertEdge(nodeNum - (maxLine - 1), nodeNum);
+                insertEdge(s, nodeNum, nodeNum - (maxLine - 1));
+                insertEdge(s, nodeNum - (maxLine - 1), nodeNum);
             }
             if (column > 1)
             {
-                insertEdge(nodeNum, nodeNum - (maxLine - 1) - 1);
-                insertEdge(nodeNum - (maxLine - 1) - 1, nodeNum);
+                insertEdge(s, nodeNum, nodeNum - (maxLine - 1) - 1);
+                insertEdge(s, nodeNum - (maxLine - 1) - 1, nodeNum);
             }
         }
     }
     if (column > 1)
     {
-        insertEdge(nodeNum, nodeNum - 1);
-        insertEdge(nodeNum - 1, nodeNum);
+        insertEdge(s, nodeNum, nodeNum - 1);
+        insertEdge(s, nodeNum - 1, nodeNum);
     }
 }
 
@@ -93,6 +95,130 @@ int calculateWeight(struct PNG *p, int w, int h)
     return 255 * 255 * 3 - r * r - g * g - b * b;
 }
 
+// Hilbert 曲线上 (x, y) 的序号，n 为 2 的幂
+int hilbertIndex(int n, int x, int y)
+{
+    int d = 0;
+    for (int k = n / 2; k > 0; k /= 2)
+    {
+        int rx = (x & k) > 0;
+        int ry = (y & k) > 0;
+        d += k * k * ((3 * rx) ^ ry);
+        if (ry == 0)
+        {
+            if (rx == 1)
+            {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            int t = x;
+            x = y;
+            y = t;
+        }
+    }
+    return d;
+}
+
+// 块内的 Morton 序：行列的二进制位交错
+int mortonIndex(int x, int y)
+{
+    int d = 0;
+    for (int b = 0; (1 << b) < ORDER_TILE; b++)
+    {
+        d |= ((x >> b) & 1) << (2 * b + 1);
+        d |= ((y >> b) & 1) << (2 * b);
+    }
+    return d;
+}
+
+struct OrderKey
+{
+    int key;
+    int node;
+};
+
+int compareKey(const void *a, const void *b)
+{
+    const struct OrderKey *x = (const struct OrderKey *)a;
+    const struct OrderKey *y = (const struct OrderKey *)b;
+    if (x->key != y->key)
+        return x->key < y->key ? -1 : 1;
+    return x->node - y->node;
+}
+
+// 按空间填充曲线重新编号：块按 Hilbert 曲线排列，块内按 Morton 序，
+// 权值、邻接表和 cellRow/cellCol 都换成新编号，同一个点的边在 edge 中连续存放
+void reorder(struct State *s)
+{
+    int n = s->nodeNum;
+    int tiles = 1;
+    while (tiles * ORDER_TILE < s->row - 1 || tiles * ORDER_TILE < s->column)
+    {
+        tiles *= 2;
+    }
+    struct OrderKey *keys = new OrderKey[n + 1];
+    for (int i = 1; i <= n; i++)
+    {
+        int r = s->cellRow[i], c = s->cellCol[i];
+        keys[i].key = hilbertIndex(tiles, r / ORDER_TILE, c / ORDER_TILE) * ORDER_TILE * ORDER_TILE + mortonIndex(r % ORDER_TILE, c % ORDER_TILE);
+        keys[i].node = i;
+    }
+    qsort(keys + 1, n, sizeof(struct OrderKey), compareKey);
+
+    int *perm = new int[n + 1]; // 旧编号 -> 新编号
+    int *oldWeight = new int[n + 1];
+    int *oldRow = new int[n + 1];
+    int *oldCol = new int[n + 1];
+    int *oldPixel = new int[n + 1];
+    int *oldHead = new int[n + 1];
+    Edge *oldEdge = new Edge[s->edgeNum + 1];
+    int *list = new int[s->edgeNum + 1];
+    for (int i = 1; i <= n; i++)
+    {
+        perm[keys[i].node] = i;
+        oldWeight[i] = s->weight[i];
+        oldRow[i] = s->cellRow[i];
+        oldCol[i] = s->cellCol[i];
+        oldPixel[i] = s->cellPixel[i];
+        oldHead[i] = s->head[i];
+    }
+    memcpy(oldEdge, s->edge, sizeof(Edge) * (s->edgeNum + 1));
+
+    s->edgeNum = 0;
+    for (int v = 1; v <= n; v++)
+    {
+        int u = keys[v].node;
+        s->weight[v] = oldWeight[u];
+        s->cellRow[v] = oldRow[u];
+        s->cellCol[v] = oldCol[u];
+        s->cellPixel[v] = oldPixel[u];
+        s->cellNode[oldRow[u] * s->column + oldCol[u]] = v;
+        s->head[v] = 0;
+        // 头插法会把顺序反过来，先倒序收集，保持遍历顺序不变
+        int cnt = 0;
+        for (int i = oldHead[u]; i != 0; i = oldEdge[i].next)
+        {
+            list[cnt++] = perm[oldEdge[i].vertex];
+        }
+        while (cnt > 0)
+        {
+            insertEdge(s, v, list[--cnt]);
+        }
+    }
+    s->source = perm[s->source];
+    s->target = perm[s->target];
+
+    delete[] keys;
+    delete[] perm;
+    delete[] oldWeight;
+    delete[] oldRow;
+    delete[] oldCol;
+    delete[] oldPixel;
+    delete[] oldHead;
+    delete[] oldEdge;
+    delete[] list;
+}
+
 void parse(struct State *s, struct PNG *p)
 {
     int height = get_height(p);
@@ -108,6 +234,7 @@ void parse(struct State *s, struct PNG *p)
             if (weight == 0)
                 continue;
             buildEdge(s, weight, line);
+            s->cellPixel[s->nodeNum] = (w - 6) / 8;
             line++;
         }
         if (s->row == 1)
@@ -117,29 +244,53 @@ void parse(struct State *s, struct PNG *p)
         line = 1;
         (s->row)++;
     }
+    s->target = s->nodeNum;
+    for (int i = 1; i <= s->nodeNum; i++)
+    {
+        s->cellNode[s->cellRow[i] * s->column + s->cellCol[i]] = i;
+    }
+    if (s->order == ORDER_HILBERT)
+    {
+        reorder(s);
+    }
     return;
 }
 
+int node_of(struct State *s, int row, int col)
+{
+    if (row < 0 || row >= s->row - 1 || col < 0 || col >= s->column)
+    {
+        return 0;
+    }
+    return s->cellNode[row * s->column + col];
+}
+
+void cell_of(struct State *s, int node, int *row, int *col)
+{
+    *row = s->cellRow[node];
+    *col = s->cellCol[node];
+}
+
 int solve1(struct State *s)
 {
     // TODO
-    s->visited[1] = 1;
-    s->pathLength[1] = 0;
-    s->minPath[1] = -1;
-    int k = 1;            // 加入路径的点的数量
-    int currentPoint = 1; // 当前所选择的点
-    while (k < nodeNum)
+    s->visited[s->source] = 1;
+    s->pathLength[s->source] = 0;
+    s->minPath[s->source] = -1;
+    int k = 1;                    // 加入路径的点的数量
+    int currentPoint = s->source; // 当前所选择的点
+    while (k < s->nodeNum)
     {
-        for (int i = head[currentPoint]; i != 0; i = edge[i].next)
+        for (int i = s->head[currentPoint]; i != 0; i = s->edge[i].next)
         {
-            if (!s->visited[edge[i].vertex] && s->pathLength[edge[i].vertex] > s->pathLength[currentPoint] + Point[edge[i].vertex].weight)
+            if (!s->visited[s->edge[i].vertex] && s->pathLength[s->edge[i].vertex] > s->pathLength[currentPoint] + s->weight[s->edge[i].vertex])
             {
-                s->pathLength[edge[i].vertex] = s->pathLength[currentPoint] + Point[edge[i].vertex].weight;
-                s->minPath[edge[i].vertex] = currentPoint;
+                s->pathLength[s->edge[i].vertex] = s->pathLength[currentPoint] + s->weight[s->edge[i].vertex];
+                s->minPath[s->edge[i].vertex] = currentPoint;
             }
         }
         int minDistance = INF;
-        for (int i = 1; i <= nodeNum; i++)
+        for (int i = 1; i <= s->nodeNum; i++)
         {
             if (!s->visited[i] && minDistance > s->pathLength[i])
             {
@@ -151,21 +302,21 @@ int solve1(struct State *s)
         s->pathLength[currentPoint] = minDistance;
         k++;
     }
-    return s->pathLength[nodeNum];
+    return s->pathLength[s->target];
 }
 
 int solve2(struct State *s)
 {
     // TODO
     int u = 0; //
-    int minLength = s->pathLength[nodeNum];
-    for (int i = nodeNum; i != -1; i = s->minPath[i])
+    int minLength = s->pathLength[s->target];
+    for (int i = s->target; s->minPath[i] != -1; i = s->minPath[i])
     {
         u = s->minPath[i];
         int tempEdge = 0;
-        for (int p = head[u]; p; p = edge[p].next)
+        for (int p = s->head[u]; p; p = s->edge[p].next)
         {
-            if (edge[p].vertex == i)
+            if (s->edge[p].vertex == i)
             {
                 tempEdge = p;
                 break;
@@ -174,25 +325,25 @@ int solve2(struct State *s)
         s->deletedEdge = tempEdge; // 删除边
         // dijkstra
         memset(s->visited, 0, sizeof(s->visited));
-        for (int i = 0; i <= MAX; i++)
+        for (int i = 0; i < MAX; i++)
         {
             s->pathLength[i] = INF;
         }
-        s->visited[1] = 1;
-        s->pathLength[1] = 0;
-        int k = 1;            // 加入路径的点的数量
-        int currentPoint = 1; // 当前所选择的点
-        while (k < nodeNum)
+        s->visited[s->source] = 1;
+        s->pathLength[s->source] = 0;
+        int k = 1;                    // 加入路径的点的数量
+        int currentPoint = s->source; // 当前所选择的点
+        while (k < s->nodeNum)
         {
-            for (int i = head[currentPoint]; i != 0; i = edge[i].next)
+            for (int i = s->head[currentPoint]; i != 0; i = s->edge[i].next)
             {
-                if (i != s->deletedEdge && !s->visited[edge[i].vertex] && s->pathLength[edge[i].vertex] > s->pathLength[currentPoint] + Point[edge[i].vertex].weight)
+                if (i != s->deletedEdge && !s->visited[s->edge[i].vertex] && s->pathLength[s->edge[i].vertex] > s->pathLength[currentPoint] + s->weight[s->edge[i].vertex])
                 {
-                    s->pathLength[edge[i].vertex] = s->pathLength[currentPoint] + Point[edge[i].vertex].weight;
+                    s->pathLength[s->edge[i].vertex] = s->pathLength[currentPoint] + s->weight[s->edge[i].vertex];
                 }
             }
             int minDistance = INF;
-            for (int i = 1; i <= nodeNum; i++)
+            for (int i = 1; i <= s->nodeNum; i++)
             {
                 if (!s->visited[i] && minDistance > s->pathLength[i])
                 {
@@ -206,10 +357,306 @@ int solve2(struct State *s)
             s->pathLength[currentPoint] = minDistance;
             k++;
         }
-        if (s->pathLength[nodeNum] > minLength && s->secondMinPath > s->pathLength[nodeNum])
+        if (s->pathLength[s->target] > minLength && s->secondMinPath > s->pathLength[s->target])
         {
-            s->secondMinPath = s->pathLength[nodeNum];
+            s->secondMinPath = s->pathLength[s->target];
         }
     }
     return s->secondMinPath;
 }
+
+void init_Frames(struct Frames *f, int slice)
+{
+    for (int i = 0; i < MAX_FRAME; i++)
+    {
+        f->files[i] = NULL;
+        f->weights[i] = NULL;
+        f->failed[i] = 0;
+    }
+    f->count = 0;
+    f->slice = slice;
+    f->loaded = 0;
+}
+
+void delete_Frames(struct Frames *f)
+{
+    for (int i = 0; i < f->count; i++)
+    {
+        delete[] f->weights[i];
+        f->weights[i] = NULL;
+    }
+}
+
+// 只记录文件名并检查文件头，真正用到该帧时才解码
+// 帧数已到上限返回 1，文件打不开或不是 PNG 返回 2
+int add_Frame(struct Frames *f, const char *file_name)
+{
+    if (f->count >= MAX_FRAME)
+    {
+        return 1;
+    }
+    FILE *fp = fopen(file_name, "rb");
+    if (!fp)
+    {
+        perror(file_name);
+        return 2;
+    }
+    png_byte header[8];
+    int bad = fread(header, 1, 8, fp) != 8 || png_sig_cmp(header, 0, 8);
+    fclose(fp);
+    if (bad)
+    {
+        fprintf(stderr, "%s: not a valid PNG file\n", file_name);
+        return 2;
+    }
+    f->files[f->count++] = file_name;
+    return 0;
+}
+
+struct FrameReader
+{
+    struct State *s;
+    int *weights;
+};
+
+// 逐行回调：只看采样行，每个采样列按建图时的 cellPixel 对应到底图的点；
+// 底图在这一列留白就跳过，帧在这一格留白则保留底图的权值
+static void readFrameRow(void *ctx, int y, struct PXL *row, int width, int height)
+{
+    struct FrameReader *reader = (struct FrameReader *)ctx;
+    struct State *s = reader->s;
+    if (y < 6 || (y - 6) % 8 != 0)
+    {
+        return;
+    }
+    int r = (y - 6) / 8;
+    int line = 0; // 本行下一个点在底图中的列
+    for (int w = 6, x = 0; w < width; w += 8, x++)
+    {
+        int node = node_of(s, r, line);
+        if (node == 0 || s->cellRow[node] != r || s->cellPixel[node] != x)
+            continue;
+        line++;
+        int weight = 255 * 255 * 3 - row[w].red * row[w].red - row[w].green * row[w].green - row[w].blue * row[w].blue;
+        if (weight != 0)
+        {
+            reader->weights[node] = weight;
+        }
+    }
+    (void)height;
+}
+
+// 第 k 帧的权值，第一次用到时通过 load_rows 流式解码，不保存整张图片；
+// 帧中缺失的格子沿用建图时的权值。解码失败返回 NULL，并记在 failed 里，不再重复打开
+int *frameWeights(struct State *s, struct Frames *f, int k)
+{
+    if (f->weights[k] == NULL && !f->failed[k])
+    {
+        struct FrameReader reader;
+        reader.s = s;
+        reader.weights = new int[s->nodeNum + 1];
+        memcpy(reader.weights, s->weight, sizeof(int) * (s->nodeNum + 1));
+        if (load_rows(f->files[k], readFrameRow, &reader))
+        {
+            delete[] reader.weights;
+            f->failed[k] = 1;
+            return NULL;
+        }
+        f->weights[k] = reader.weights;
+        f->loaded++;
+    }
+    return f->weights[k];
+}
+
+// 时间相关的最短路：从 u 进入 v 的代价取 u 的到达时刻所在帧中 v 的权值，
+// 超过最后一帧后一直使用最后一帧。图的结构由 parse 时的地图决定，各帧只替换权值。
+// 帧间权值可能突降，此时先到达不一定更优（不满足 FIFO），结果为不允许等待时的到达时间；
+// 用到的帧解码失败时返回 -1
+int solveTimed(struct State *s, struct Frames *f)
+{
+    if (f->count == 0 || f->slice <= 0)
+    {
+        return solve1(s);
+    }
+    for (int i = 1; i <= s->nodeNum; i++)
+    {
+        s->pathLength[i] = INF;
+        s->visited[i] = 0;
+    }
+    s->visited[s->source] = 1;
+    s->pathLength[s->source] = 0;
+    s->minPath[s->source] = -1;
+    int k = 1;                    // 加入路径的点的数量
+    int currentPoint = s->source; // 当前所选择的点
+    while (k < s->nodeNum)
+    {
+        int frame = s->pathLength[currentPoint] / f->slice;
+        int *weight = frameWeights(s, f, frame < f->count ? frame : f->count - 1);
+        if (weight == NULL)
+        {
+            return -1;
+        }
+        for (int i = s->head[currentPoint]; i != 0; i = s->edge[i].next)
+        {
+            int v = s->edge[i].vertex;
+            if (!s->visited[v] && s->pathLength[v] > s->pathLength[currentPoint] + weight[v])
+            {
+                s->pathLength[v] = s->pathLength[currentPoint] + weight[v];
+                s->minPath[v] = currentPoint;
+            }
+        }
+        int minDistance = INF;
+        for (int i = 1; i <= s->nodeNum; i++)
+        {
+            if (!s->visited[i] && minDistance > s->pathLength[i])
+            {
+                currentPoint = i;
+                minDistance = s->pathLength[i];
+            }
+        }
+        if (minDistance == INF)
+            break;
+        s->visited[currentPoint] = 1;
+        k++;
+    }
+    return s->pathLength[s->target];
+}
+
+// 波前松弛：把点铺回稠密的行列网格，反复做 min-plus 扫描直到一轮没有变化。
+// 每行两侧各留至少一格 INF 作为边界，行内长度补齐到 8 的倍数，补齐的格子权值为 INF，
+// 距离永远不会小于 INF（INF + INF 仍在 int 范围内）
+#define WAVE_LANE 8
+
+// 用相邻行更新一行：d[j] = min(d[j], min(up[j], up[j + 1]) + w[j])，n 为 WAVE_LANE 的倍数
+static int relaxRowScalar(int *d, const int *up, const int *w, int n)
+{
+    int changed = 0;
+    for (int j = 0; j < n; j++)
+    {
+        int cand = (up[j] < up[j + 1] ? up[j] : up[j + 1]) + w[j];
+        if (cand < d[j])
+        {
+            d[j] = cand;
+            changed = 1;
+        }
+    }
+    return changed;
+}
+
+#ifdef WAVE_AVX2
+// 同上，每条指令处理 8 个格子
+__attribute__((target("avx2"))) static int relaxRowAvx2(int *d, const int *up, const int *w, int n)
+{
+    __m256i changed = _mm256_setzero_si256();
+    for (int j = 0; j < n; j += WAVE_LANE)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(up + j));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(up + j + 1));
+        __m256i cand = _mm256_add_epi32(_mm256_min_epi32(a, b), _mm256_loadu_si256((const __m256i *)(w + j)));
+        __m256i old = _mm256_loadu_si256((const __m256i *)(d + j));
+        __m256i now = _mm256_min_epi32(old, cand);
+        changed = _mm256_or_si256(changed, _mm256_cmpgt_epi32(old, now));
+        _mm256_storeu_si256((__m256i *)(d + j), now);
+    }
+    return !_mm256_testz_si256(changed, changed);
+}
+#endif
+
+// 行内左右相邻的更新有先后依赖，正反各扫一遍
+static int relaxLine(int *d, const int *w, int n)
+{
+    int changed = 0;
+    for (int j = 1; j < n; j++)
+    {
+        if (d[j - 1] + w[j] < d[j])
+        {
+            d[j] = d[j - 1] + w[j];
+            changed = 1;
+        }
+    }
+    for (int j = n - 2; j >= 0; j--)
+    {
+        if (d[j + 1] + w[j] < d[j])
+        {
+            d[j] = d[j + 1] + w[j];
+            changed = 1;
+        }
+    }
+    return changed;
+}
+
+// 与 solve1 结果相同的另一种求解方式，同时填好 pathLength 和 minPath，可以接着调用 solve2
+int solveWave(struct State *s)
+{
+    int rows = s->row - 1;
+    int cols = s->column;
+    int n = (cols + WAVE_LANE - 1) / WAVE_LANE * WAVE_LANE; // 每行参与计算的格数
+    int stride = n + WAVE_LANE;                               // 第 0 格和 n + 1 之后为边界
+    int (*relaxRow)(int *, const int *, const int *, int) = relaxRowScalar;
+#ifdef WAVE_AVX2
+    if (__builtin_cpu_supports("avx2"))
+    {
+        relaxRow = relaxRowAvx2;
+    }
+#endif
+    int *d = new int[rows * stride];
+    int *w = new int[rows * stride];
+    for (int i = 0; i < rows * stride; i++)
+    {
+        d[i] = INF;
+        w[i] = INF;
+    }
+    for (int v = 1; v <= s->nodeNum; v++)
+    {
+        w[s->cellRow[v] * stride + s->cellCol[v] + 1] = s->weight[v];
+    }
+    d[s->cellRow[s->source] * stride + s->cellCol[s->source] + 1] = 0;
+
+    // 长行（第 0, 2, 4... 行）的第 c 格与相邻短行的 c - 1、c 格相连，短行的第 c 格与相邻长行的 c、c + 1 格相连
+    int changed = 1;
+    s->sweeps = 0;
+    while (changed)
+    {
+        changed = 0;
+        s->sweeps++;
+        for (int r = 0; r < rows; r++)
+        {
+            int *line = d + r * stride + 1;
+            if (r > 0)
+            {
+                changed |= relaxRow(line, d + (r - 1) * stride + (r % 2 == 0 ? 0 : 1), w + r * stride + 1, n);
+            }
+            changed |= relaxLine(line, w + r * stride + 1, cols);
+        }
+        for (int r = rows - 2; r >= 0; r--)
+        {
+            int *line = d + r * stride + 1;
+            changed |= relaxRow(line, d + (r + 1) * stride + (r % 2 == 0 ? 0 : 1), w + r * stride + 1, n);
+            changed |= relaxLine(line, w + r * stride + 1, cols);
+        }
+    }
+
+    for (int v = 1; v <= s->nodeNum; v++)
+    {
+        s->pathLength[v] = d[s->cellRow[v] * stride + s->cellCol[v] + 1];
+        s->visited[v] = 1;
+    }
+    // 最短路树：前驱取第一个满足 pathLength[u] + weight[v] == pathLength[v] 的邻点
+    for (int v = 1; v <= s->nodeNum; v++)
+    {
+        s->minPath[v] = 0;
+        for (int i = s->head[v]; i != 0; i = s->edge[i].next)
+        {
+            int u = s->edge[i].vertex;
+            if (s->pathLength[u] + s->weight[v] == s->pathLength[v])
+            {
+                s->minPath[v] = u;
+                break;
+            }
+        }
+    }
+    s->minPath[s->source] = -1;
+    delete[] d;
+    delete[] w;
+    return s->pathLength[s->target];
+}
@@ -1,5 +1,6 @@
 #include "../include/suan_png.h"
 #include <stdlib.h>
+#include <string.h>
 
 void init_PNG(struct PNG *p)
 {
@@ -11,7 +12,7 @@ void delete_PNG(struct PNG *p)
 {
     delete[] p->image;
 }
-int load(struct PNG *p, const char *file_name)
+int load_rows(const char *file_name, void (*row_fn)(void *ctx, int y, struct PXL *row, int width, int height), void *ctx)
 {
     FILE *fp = fopen(file_name, "rb");
     if (!fp)
@@ -66,12 +67,12 @@ int load(struct PNG *p, const char *file_name)
     }
     size_t width = png_get_image_width(png_ptr, info_ptr);
     size_t height = png_get_image_height(png_ptr, info_ptr);
-    PXL *new_pixs = nullptr;
+    PXL *pixs = nullptr;
     png_byte *row = nullptr;
     png_read_update_info(png_ptr, info_ptr);
     if (setjmp(png_jmpbuf(png_ptr)))
     {
-        delete[] new_pixs;
+        delete[] pixs;
         delete[] row;
         png_destroy_read_struct(&png_ptr, &info_ptr, nullptr);
         fclose(fp);
@@ -79,7 +80,7 @@ int load(struct PNG *p, const char *file_name)
         return 1;
     }
     int bpr = png_get_rowbytes(png_ptr, info_ptr);
-    new_pixs = new PXL[height * width];
+    pixs = new PXL[width];
     row = new png_byte[bpr];
     int numchannels = png_get_channels(png_ptr, info_ptr);
     for (size_t y = 0; y < height; y++)
@@ -88,7 +89,7 @@ int load(struct PNG *p, const char *file_name)
         png_byte *pix = (png_byte *)row;
         for (size_t x = 0; x < width; x++)
         {
-            PXL &px = new_pixs[width * y + x];
+            PXL &px = pixs[x];
             if (numchannels == 1 || numchannels == 2)
             {
                 unsigned char color = (unsigned char)*pix++;
@@ -119,17 +120,44 @@ int load(struct PNG *p, const char *file_name)
                 }
             }
         }
+        row_fn(ctx, y, pixs, width, height);
     }
-    delete[] p->image;
-    p->image = new_pixs;
-    p->width = width;
-    p->height = height;
+    delete[] pixs;
     delete[] row;
     png_read_end(png_ptr, nullptr);
     png_destroy_read_struct(&png_ptr, &info_ptr, nullptr);
     fclose(fp);
     return 0;
 }
+
+// load 的逐行回调：第一行到来时按图片大小分配内存，之后逐行拷入
+static void copy_row(void *ctx, int y, struct PXL *row, int width, int height)
+{
+    struct PNG *img = (struct PNG *)ctx;
+    if (y == 0)
+    {
+        img->image = new PXL[height * width];
+        img->width = width;
+        img->height = height;
+    }
+    memcpy(img->image + (size_t)width * y, row, sizeof(struct PXL) * width);
+}
+
+int load(struct PNG *p, const char *file_name)
+{
+    struct PNG img;
+    init_PNG(&img);
+    if (load_rows(file_name, copy_row, &img))
+    {
+        delete[] img.image;
+        return 1;
+    }
+    delete[] p->image;
+    p->image = img.image;
+    p->width = img.width;
+    p->height = img.height;
+    return 0;
+}
 int save(struct PNG *p, const char *file_name)
 {
     FILE *fp = fopen(file_name, "wb");
@@ -1,126 +1,230 @@
+#include "suan_png.h"
+#include "pxl.h"
+#include "state.h"
 #include <stdio.h>
-#include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
-#include <signal.h>
-#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <thread>
+#include <vector>
+
+#define MAX_CASE 64
+#define DEFAULT_BUDGET_MS 1000.0
+
+// 求解方式
+#define ENGINE_DIJKSTRA 0 // solve1
+#define ENGINE_TIMED 1    // solveTimed，两帧都是同一张图，结果应与 solve1 相同
+#define ENGINE_WAVE 2     // solveWave
+
+// 用例出错的原因
+#define ERROR_MAP 1   // 读图失败
+#define ERROR_FRAME 2 // timed 的帧读取失败
 
-#include <sys/types.h>
-#include <sys/wait.h>
-#include <sys/stat.h>
-#include <fcntl.h>
+struct Variant {
+    const char *name;
+    int order;
+    int engine;
+};
 
-int test1();
+// 每张图都用下面几种方式各求解一次
+const struct Variant variants[] = {
+    { "row", ORDER_ROW, ENGINE_DIJKSTRA },
+    { "hilbert", ORDER_HILBERT, ENGINE_DIJKSTRA },
+    { "timed", ORDER_ROW, ENGINE_TIMED },
+    { "wave", ORDER_HILBERT, ENGINE_WAVE },
+};
+const int variant_cnt = sizeof(variants) / sizeof(variants[0]);
 
-int test2();
+// 一组测试：pic/testN.png 对应 output/partN_sol.txt
+struct Case {
+    int id;
+    int variant;       // variants 中的下标
+    char map_file[64];
+    char sol_file[64];
+    int expect[2];     // 标准答案：最短路、次短路
+    int answer[2];     // 本次求解结果
+    double budget_ms;  // 时间预算
+    double elapsed_ms; // 实际耗时：本线程的 CPU 时间（读图 + 建图 + 求解）
+    int error;         // 非 0 表示出错，见 ERROR_MAP、ERROR_FRAME
+};
 
 int usage();
 
-int main() {
-    test1();
-    test2();
-    return 0;
+int load_cases(struct Case *cases, double default_budget);
+
+void load_budget(struct Case *cases, int n);
+
+double thread_ms();
+
+void run_case(struct Case *c);
+
+int report(struct Case *cases, int n);
+
+int main(int argc, char **argv) {
+    double default_budget = DEFAULT_BUDGET_MS;
+    int opt;
+    while ((opt = getopt(argc, argv, "b:h")) != -1) {
+        if (opt == 'b') {
+            default_budget = atof(optarg);
+        } else {
+            usage();
+        }
+    }
+    if (default_budget <= 0) {
+        usage();
+    }
+
+    static struct Case cases[MAX_CASE];
+    int n = load_cases(cases, default_budget);
+    if (n == 0) {
+        printf("[失败] 没有找到测试用例 (pic/testN.png + output/partN_sol.txt)\n");
+        return 1;
+    }
+    load_budget(cases, n);
+
+    // 每个用例各自持有 PNG 和 State，互不干扰，可以同时求解
+    std::vector<std::thread> workers;
+    for (int i = 0; i < n; i++) {
+        workers.push_back(std::thread(run_case, &cases[i]));
+    }
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+    return report(cases, n);
 }
 
 int usage() {
-    printf("Usage: ./test [option]\n[option]: 选择 part1 或 part2\n");
+    printf("Usage: ./test [-b budget_ms]\n"
+           "[-b]: 未在 output/budget.txt 中列出的用例的默认时间预算（毫秒），默认 %.0f\n", DEFAULT_BUDGET_MS);
     exit(1);
 }
 
-int test1() {
-    pid_t p1 = fork();
-    if (p1 == 0) {          //child process
-        int fd = open("output/part1.txt", O_RDWR | O_CLOEXEC | O_TRUNC | O_CREAT, S_IRWXU | S_IRWXG);
-        if (fd < 0) {
-            perror("Failed to open txt file ");
-            exit(1);
+// 按编号依次寻找图片和答案，遇到第一个缺失的编号停止
+int load_cases(struct Case *cases, double default_budget) {
+    int n = 0;
+    for (int id = 1; n + variant_cnt <= MAX_CASE; id++) {
+        struct Case *c = &cases[n];
+        memset(c, 0, sizeof(*c));
+        c->id = id;
+        snprintf(c->map_file, sizeof(c->map_file), "pic/test%d.png", id);
+        snprintf(c->sol_file, sizeof(c->sol_file), "output/part%d_sol.txt", id);
+        if (access(c->map_file, R_OK) != 0) {
+            break;
         }
-        dup2(fd, STDOUT_FILENO);
-        execlp("./part1", "./part1", NULL);
-        perror("Execlp Failed: ");    //this line is not supposed to be executed
-        exit(1);                      //this line is not supposed to be executed
-    } else if (p1 > 0) {       //parent process
-        int status;
-        pid_t w_result = waitpid(p1, &status, 0);
-
-        if (w_result == -1) {
-            perror("Failed to wait");
-            exit(1);
+        FILE *fp = fopen(c->sol_file, "r");
+        if (!fp) {
+            break;
         }
-
-        pid_t p2 = fork();
-        if (p2 == 0) {
-            int fd_null = open("/dev/null", O_RDWR);
-            dup2(fd_null, STDOUT_FILENO);
-            execlp("diff", "diff", "output/part1.txt", "output/part1_sol.txt", NULL);
-            perror("Execlp diff Failed: ");    //this line is not supposed to be executed
-            exit(1);
-        } else if (p2 > 0) {
-            int status2;
-            waitpid(p2, &status2, 0);
-            if (WIFEXITED(status2)) {
-                if (WEXITSTATUS(status2) != 0) {
-                    printf("[失败] 测试 1\n");
-                } else {
-                    printf("[通过] 测试 1\n本地测试比较简单，请再三检查之后再上传！\n");
-                }
-            }
-        } else {
-            perror("Failed to fork");
+        if (fscanf(fp, "%d%d", &c->expect[0], &c->expect[1]) != 2) {
+            fclose(fp);
+            printf("[失败] %s 格式错误\n", c->sol_file);
             exit(1);
         }
-    } else {
-        perror("Failed to fork");
-        exit(1);
+        fclose(fp);
+        c->budget_ms = default_budget;
+        for (int v = 1; v < variant_cnt; v++) {
+            cases[n + v] = *c;
+            cases[n + v].variant = v;
+        }
+        n += variant_cnt;
     }
-    return 1;
+    return n;
 }
 
-int test2() {
-    pid_t p1 = fork();
-    if (p1 == 0) {          //child process
-        int fd = open("output/part2.txt", O_RDWR | O_CLOEXEC | O_TRUNC | O_CREAT, S_IRWXU | S_IRWXG);
-        if (fd < 0) {
-            perror("Failed to open txt file ");
-            exit(1);
+// output/budget.txt 每行 "partN 毫秒"，# 开头为注释
+void load_budget(struct Case *cases, int n) {
+    FILE *fp = fopen("output/budget.txt", "r");
+    if (!fp) {
+        return;
+    }
+    char line[128];
+    while (fgets(line, sizeof(line), fp)) {
+        int id;
+        double ms;
+        if (line[0] == '#' || sscanf(line, "part%d %lf", &id, &ms) != 2) {
+            continue;
         }
-        dup2(fd, STDOUT_FILENO);
-        execlp("./part2", "./part2", NULL);
-        perror("Execlp Failed: ");    //this line is not supposed to be executed
-        exit(1);                      //this line is not supposed to be executed
-    } else if (p1 > 0) {       //parent process
-        int status;
-        pid_t w_result = waitpid(p1, &status, 0);
-
-        if (w_result == -1) {
-            perror("Failed to wait");
-            exit(1);
+        for (int i = 0; i < n; i++) {
+            if (cases[i].id == id) {
+                cases[i].budget_ms = ms;
+            }
         }
+    }
+    fclose(fp);
+}
 
-        pid_t p2 = fork();
-        if (p2 == 0) {
-            int fd_null = open("/dev/null", O_RDWR);
-            dup2(fd_null, STDOUT_FILENO);
-            execlp("diff", "diff", "output/part2.txt", "output/part2_sol.txt", NULL);
-            perror("Execlp diff Failed: ");    //this line is not supposed to be executed
-            exit(1);
-        } else if (p2 > 0) {
-            int status2;
-            waitpid(p2, &status2, 0);
-            if (WIFEXITED(status2)) {
-                if (WEXITSTATUS(status2) != 0) {
-                    printf("[失败] 测试 2\n");
-                } else {
-                    printf("[通过] 测试 2\n本地测试比较简单，请再三检查之后再上传！\n");
+// 本线程已用的 CPU 时间（毫秒）；各用例同时运行，用墙上时间会把等待调度的时间也算进去
+double thread_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+void run_case(struct Case *c) {
+    double start = thread_ms();
+    struct PNG *png = new PNG();
+    init_PNG(png);
+    if (load(png, c->map_file)) {
+        c->error = ERROR_MAP;
+    } else {
+        State *state = new State();
+        init_State(state);
+        set_order(state, variants[c->variant].order);
+        parse(state, png);
+        if (variants[c->variant].engine == ENGINE_TIMED) {
+            struct Frames frames;
+            init_Frames(&frames, 1);
+            if (add_Frame(&frames, c->map_file) || add_Frame(&frames, c->map_file)) {
+                c->error = ERROR_FRAME;
+            } else {
+                c->answer[0] = solveTimed(state, &frames);
+                if (c->answer[0] < 0) {
+                    c->error = ERROR_FRAME;
                 }
             }
+            delete_Frames(&frames);
+        } else if (variants[c->variant].engine == ENGINE_WAVE) {
+            c->answer[0] = solveWave(state);
         } else {
-            perror("Failed to fork");
-            exit(1);
+            c->answer[0] = solve1(state);
         }
-    } else {
-        perror("Failed to fork");
-        exit(1);
+        // solve2 沿第一次求解留下的最短路删边，第一次没有解出来就不能做
+        if (!c->error) {
+            c->answer[1] = solve2(state);
+        }
+        delete_State(state);
+        delete state;
+    }
+    delete_PNG(png);
+    delete png;
+    c->elapsed_ms = thread_ms() - start;
+}
+
+// 答案错误和超出时间预算都算失败，有失败时返回非 0
+int report(struct Case *cases, int n) {
+    int failed = 0;
+    for (int i = 0; i < n; i++) {
+        struct Case *c = &cases[i];
+        if (c->error == ERROR_MAP) {
+            printf("[失败] 测试 %d (%s): 无法读取 %s\n", c->id, variants[c->variant].name, c->map_file);
+            failed++;
+        } else if (c->error == ERROR_FRAME) {
+            printf("[失败] 测试 %d (%s): 无法读取帧 %s\n", c->id, variants[c->variant].name, c->map_file);
+            failed++;
+        } else if (c->answer[0] != c->expect[0] || c->answer[1] != c->expect[1]) {
+            printf("[失败] 测试 %d (%s): 输出 %d %d，应为 %d %d\n", c->id, variants[c->variant].name, c->answer[0], c->answer[1], c->expect[0], c->expect[1]);
+            failed++;
+        } else if (c->elapsed_ms > c->budget_ms) {
+            printf("[超时] 测试 %d (%s): 用时 %.2f ms，超过预算 %.0f ms\n", c->id, variants[c->variant].name, c->elapsed_ms, c->budget_ms);
+            failed++;
+        } else {
+            printf("[通过] 测试 %d (%s): 用时 %.2f ms / 预算 %.0f ms\n", c->id, variants[c->variant].name, c->elapsed_ms, c->budget_ms);
+        }
+    }
+    if (failed == 0) {
+        printf("本地测试比较简单，请再三检查之后再上传！\n");
     }
-    return 1;
+    return failed ? 1 : 0;
 }
@@ -0,0 +1,62 @@
+#include "suan_png.h"
+#include "pxl.h"
+#include "state.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+
+int usage();
+
+int solve_algo(int slice, int count, char **files);
+
+int main(int argc, char **argv) {
+    if (argc < 3 || atoi(argv[1]) <= 0) {
+        usage();
+    }
+    return solve_algo(atoi(argv[1]), argc - 2, argv + 2);
+}
+
+int usage() {
+    printf("Usage: ./timed slice frame0.png [frame1.png ...]\n"
+           "[slice]: 每帧持续的时长，第 k 帧在 [k * slice, (k + 1) * slice) 内生效\n");
+    exit(1);
+}
+
+// 用第一帧建图，再按到达时刻选帧求最短路，输出到达终点的时刻
+int solve_algo(int slice, int count, char **files) {
+    PNG *png = new PNG();
+    init_PNG(png);
+    if (load(png, files[0])) {
+        delete png;
+        return 1;
+    }
+    State *state = new State();
+    init_State(state);
+    parse(state, png);
+    delete_PNG(png);
+    delete png;
+
+    struct Frames frames;
+    init_Frames(&frames, slice);
+    int status = 0;
+    for (int i = 0; i < count && status == 0; i++) {
+        int error = add_Frame(&frames, files[i]);
+        if (error == 1) {
+            printf("最多支持 %d 帧\n", MAX_FRAME);
+            break;
+        }
+        status = error;
+    }
+    int arrival = status ? -1 : solveTimed(state, &frames);
+    if (arrival < 0) {
+        std::cerr << "有帧无法读取，没有结果" << std::endl;
+        status = 1;
+    } else {
+        std::cout << arrival << std::endl;
+        std::cerr << "decoded " << frames.loaded << " / " << frames.count << " frames" << std::endl;
+    }
+    delete_Frames(&frames);
+    delete_State(state);
+    delete state;
+    return status ? 1 : 0;
+}